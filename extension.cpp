@@ -30,8 +30,16 @@
  */
 
 #include "extension.h"
+#include "workerpool.h"
 #include "jansson/src/jansson.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <deque>
+#include <set>
+#include <vector>
 /**
  * @file extension.cpp
  * @brief Implement extension code here.
@@ -45,6 +53,14 @@ HandleType_t				htJanssonObject;
 JanssonIteratorHandler      g_JanssonIteratorHandler;
 HandleType_t                htJanssonIterator;
 
+JanssonViewHandler			g_JanssonViewHandler;
+HandleType_t				htJanssonView;
+
+JanssonCursorHandler		g_JanssonCursorHandler;
+HandleType_t				htJanssonCursor;
+
+JanssonKeyTable				g_JanssonKeys;
+
 void JanssonObjectHandler::OnHandleDestroy(HandleType_t type, void *object) {
 	json_decref((json_t*)object);
 }
@@ -52,8 +68,211 @@ void JanssonObjectHandler::OnHandleDestroy(HandleType_t type, void *object) {
 void JanssonIteratorHandler::OnHandleDestroy(HandleType_t type, void *object) {
 }
 
+void JanssonViewHandler::OnHandleDestroy(HandleType_t type, void *object) {
+	delete (JanssonView *)object;
+}
+
+void JanssonCursorHandler::OnHandleDestroy(HandleType_t type, void *object) {
+	delete (JanssonCursor *)object;
+}
+
+JanssonView::JanssonView(json_t *root) : m_Generation(1) {
+	m_Nodes.push_back(json_incref(root));
+}
+
+JanssonView::~JanssonView() {
+	for(size_t i = 0; i < m_Nodes.size(); i++) {
+		json_decref(m_Nodes[i]);
+	}
+}
+
+json_t *JanssonView::Resolve(cell_t node) {
+	if(node == 0) {
+		return m_Nodes[0];
+	}
+
+	unsigned int index = node & (JANSSON_VIEW_MAX_NODES - 1);
+	unsigned int generation = (unsigned int)node >> JANSSON_VIEW_INDEX_BITS;
+	if(node < 0 || generation != m_Generation || index >= m_Nodes.size()) {
+		return NULL;
+	}
+
+	return m_Nodes[index];
+}
+
+cell_t JanssonView::Add(json_t *value) {
+	if(m_Nodes.size() >= JANSSON_VIEW_MAX_NODES) {
+		return -1;
+	}
+
+	// The node keeps its value alive even if the plugin removes it from
+	// the tree through another handle.
+	m_Nodes.push_back(json_incref(value));
+	return (m_Generation << JANSSON_VIEW_INDEX_BITS) | (m_Nodes.size() - 1);
+}
+
+void JanssonView::Reset() {
+	for(size_t i = 1; i < m_Nodes.size(); i++) {
+		json_decref(m_Nodes[i]);
+	}
+	m_Nodes.resize(1);
+
+	if(++m_Generation > JANSSON_VIEW_MAX_GENERATION) {
+		m_Generation = 1;
+	}
+}
+
+JanssonCursor::JanssonCursor(json_t *object) : m_Object(json_incref(object)) {
+	Reset();
+}
+
+JanssonCursor::~JanssonCursor() {
+	json_decref(m_Object);
+}
+
+bool JanssonCursor::Next() {
+	Refresh();
+
+	m_Iter = m_Next;
+	m_Key.swap(m_NextKey);
+	m_bStarted = true;
+
+	if(m_Iter != NULL) {
+		m_Next = json_object_iter_next(m_Object, m_Iter);
+		if(m_Next != NULL) {
+			m_NextKey = json_object_iter_key(m_Next);
+		}
+	}
+
+	return m_Iter != NULL;
+}
+
+void JanssonCursor::Reset() {
+	m_Iter = NULL;
+	m_Next = json_object_iter(m_Object);
+	if(m_Next != NULL) {
+		m_NextKey = json_object_iter_key(m_Next);
+	}
+
+	m_Revision = json_object_revision(m_Object);
+	m_bStarted = false;
+}
+
+void JanssonCursor::Refresh() {
+	size_t revision = json_object_revision(m_Object);
+	if(revision == m_Revision) {
+		return;
+	}
+
+	m_Revision = revision;
+
+	// The pairs we point to may have been freed and reused, so only the
+	// keys can be trusted. If the next key is gone, continue after the
+	// current one. If both are gone, there is no place left to continue.
+	if(!m_bStarted) {
+		m_Next = json_object_iter(m_Object);
+	} else {
+		if(m_Iter != NULL) {
+			m_Iter = json_object_iter_at(m_Object, m_Key.c_str());
+		}
+
+		if(m_Next != NULL) {
+			m_Next = json_object_iter_at(m_Object, m_NextKey.c_str());
+		}
+
+		if(m_Next == NULL && m_Iter != NULL) {
+			m_Next = json_object_iter_next(m_Object, m_Iter);
+		}
+	}
+
+	if(m_Next != NULL) {
+		m_NextKey = json_object_iter_key(m_Next);
+	}
+}
+
+const char *JanssonCursor::GetKey() {
+	Refresh();
+	if(m_Iter == NULL) {
+		return NULL;
+	}
+
+	return json_object_iter_key(m_Iter);
+}
+
+json_t *JanssonCursor::GetValue() {
+	Refresh();
+	if(m_Iter == NULL) {
+		return NULL;
+	}
+
+	return json_object_iter_value(m_Iter);
+}
+
+JanssonKeyTable::~JanssonKeyTable() {
+	Clear();
+}
+
+cell_t JanssonKeyTable::Prepare(const char *key) {
+	std::unordered_map<std::string, cell_t>::iterator it = m_Tokens.find(key);
+	if(it != m_Tokens.end()) {
+		return it->second;
+	}
+
+	if(m_Keys.size() >= JANSSON_MAX_KEYS) {
+		return 0;
+	}
+
+	json_key_t *prepared = json_key(key);
+	if(prepared == NULL) {
+		return 0;
+	}
+
+	m_Keys.push_back(prepared);
+	cell_t token = m_Keys.size();
+	m_Tokens[key] = token;
+	return token;
+}
+
+json_key_t *JanssonKeyTable::Resolve(cell_t token) {
+	if(token <= 0 || (size_t)token > m_Keys.size()) {
+		return NULL;
+	}
+
+	return m_Keys[token - 1];
+}
+
+void JanssonKeyTable::Clear() {
+	for(size_t i = 0; i < m_Keys.size(); i++) {
+		json_key_free(m_Keys[i]);
+	}
+	m_Keys.clear();
+	m_Tokens.clear();
+}
+
+static void OnGameFrame(bool simulating) {
+	g_JanssonWorkerPool.ProcessCompleted();
+}
+
 bool SMJansson::SDK_OnLoad(char *error, size_t err_max, bool late)
 {
+	// Seed the hash function now, jobs might create the first objects on a
+	// worker thread otherwise.
+	json_object_seed(0);
+
+	// The pool size can be set with "JanssonWorkerThreads" in core.cfg
+	unsigned int threads = JANSSON_DEFAULT_WORKER_THREADS;
+	const char *sThreads = smutils->GetCoreConfigValue("JanssonWorkerThreads");
+	if(sThreads != NULL && atoi(sThreads) > 0) {
+		threads = atoi(sThreads);
+	}
+
+	if(!g_JanssonWorkerPool.Start(threads)) {
+		snprintf(error, err_max, "Could not start the JSON worker threads.");
+		return false;
+	}
+
+	smutils->AddGameFrameHook(&OnGameFrame);
+
 	sharesys->AddNatives(myself, json_natives);
 	sharesys->RegisterLibrary(myself, "jansson");
 
@@ -65,10 +284,20 @@ bool SMJansson::SDK_OnLoad(char *error, size_t err_max, bool late)
 	
 	htJanssonObject = g_pHandleSys->CreateType("JanssonObject", &g_JanssonObjectHandler, 0, NULL, &sec, myself->GetIdentity(), NULL);
     htJanssonIterator = g_pHandleSys->CreateType("JanssonIterator", &g_JanssonIteratorHandler, 0, NULL, &sec, myself->GetIdentity(), NULL);
+	htJanssonView = g_pHandleSys->CreateType("JanssonView", &g_JanssonViewHandler, 0, NULL, &sec, myself->GetIdentity(), NULL);
+	htJanssonCursor = g_pHandleSys->CreateType("JanssonCursor", &g_JanssonCursorHandler, 0, NULL, &sec, myself->GetIdentity(), NULL);
 
 	return true;
 }
 
+void SMJansson::SDK_OnUnload()
+{
+	smutils->RemoveGameFrameHook(&OnGameFrame);
+	g_JanssonWorkerPool.Shutdown();
+	g_JanssonKeys.Clear();
+	json_pool_flush();
+}
+
 //native Handle:json_object();
 static cell_t Native_json_object(IPluginContext *pContext, const cell_t *params) {
 	json_t *object = json_object();
@@ -231,6 +460,168 @@ static cell_t Native_json_object_del(IPluginContext *pContext, const cell_t *par
 	return bSuccess;
 }
 
+// Resolves a key token. Returns NULL and throws an error if it was not
+// returned by json_key_prepare().
+static json_key_t *ReadKey(IPluginContext *pContext, cell_t token) {
+	json_key_t *key = g_JanssonKeys.Resolve(token);
+	if(key == NULL) {
+		pContext->ThrowNativeError("Invalid key token %d", token);
+	}
+
+	return key;
+}
+
+//native json_key_prepare(const String:sKey[]);
+static cell_t Native_json_key_prepare(IPluginContext *pContext, const cell_t *params) {
+	// Param 1
+	char *key;
+	pContext->LocalToString(params[1], &key);
+
+	cell_t token = g_JanssonKeys.Prepare(key);
+	if(token == 0) {
+		return pContext->ThrowNativeError("Could not prepare key \"%s\", it is not valid UTF-8 or there are too many keys.", key);
+	}
+
+	return token;
+}
+
+//native Handle:json_object_get_key(Handle:hObj, iKey);
+static cell_t Native_json_object_get_key(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	// Param 2
+	json_key_t *key = ReadKey(pContext, params[2]);
+	if(key == NULL) {
+		return BAD_HANDLE;
+	}
+
+	// Return
+	json_t *result = json_object_get_key(object, key);
+	if(result == NULL) {
+		return BAD_HANDLE;
+	}
+
+	// Same as json_object_get(), the plugin owns the new handle.
+	json_incref(result);
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, result, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		pContext->ThrowNativeError("Could not create <Object> handle.");
+	}
+
+	return hndlResult;
+}
+
+//native bool:json_object_set_key(Handle:hObj, iKey, Handle:hValue);
+static cell_t Native_json_object_set_key(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	// Param 2
+	json_key_t *key = ReadKey(pContext, params[2]);
+	if(key == NULL) {
+		return 0;
+	}
+
+	// Param 3
+	json_t *value;
+	Handle_t hndlValue = static_cast<Handle_t>(params[3]);
+	if ((err=g_pHandleSys->ReadHandle(hndlValue, htJanssonObject, &sec, (void **)&value)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlValue, err);
+    }
+
+	return (json_object_set_key(object, key, value) == 0);
+}
+
+//native bool:json_object_set_new_key(Handle:hObj, iKey, Handle:hValue);
+static cell_t Native_json_object_set_new_key(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	// Param 2
+	json_key_t *key = ReadKey(pContext, params[2]);
+	if(key == NULL) {
+		return 0;
+	}
+
+	// Param 3
+	json_t *value;
+	Handle_t hndlValue = static_cast<Handle_t>(params[3]);
+	if ((err=g_pHandleSys->ReadHandle(hndlValue, htJanssonObject, &sec, (void **)&value)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlValue, err);
+    }
+
+	bool bSuccess = (json_object_set_key(object, key, value) == 0);
+	if(bSuccess) {
+		if ((err=g_pHandleSys->FreeHandle(hndlValue, NULL)) != HandleError_None)
+		{
+			return pContext->ThrowNativeError("Could not free <Object> handle %x (error %d)", hndlValue, err);
+		}
+	}
+
+	return bSuccess;
+}
+
+//native bool:json_object_del_key(Handle:hObj, iKey);
+static cell_t Native_json_object_del_key(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	// Param 2
+	json_key_t *key = ReadKey(pContext, params[2]);
+	if(key == NULL) {
+		return 0;
+	}
+
+	// Return
+	bool bSuccess = (json_object_del_key(object, key) == 0);
+	return bSuccess;
+}
+
 //native bool:json_object_clear(Handle:hObj);
 static cell_t Native_json_object_clear(IPluginContext *pContext, const cell_t *params) {
 	HandleError err;
@@ -333,8 +724,6 @@ static cell_t Native_json_object_update_missing(IPluginContext *pContext, const
 	return bSuccess;
 }
 
-//native json_object_foreach(Handle:hObj);
-
 //native Handle:json_object_iter(Handle:hObj);
 static cell_t Native_json_object_iter(IPluginContext *pContext, const cell_t *params) {
 	HandleError err;
@@ -575,39 +964,27 @@ static cell_t Native_json_object_iter_set_new(IPluginContext *pContext, const ce
     return bSuccess;
 }
 
-//native Handle:json_array();
-static cell_t Native_json_array(IPluginContext *pContext, const cell_t *params) {
-	json_t *object = json_array();
-
-	Handle_t hndl = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
-
-	if(hndl == BAD_HANDLE) {
-		pContext->ThrowNativeError("Could not create <Array> handle.");
-	}
-
-	return hndl;
-}
-
-//native json_array_size(Handle:hArray);
-static cell_t Native_json_array_size(IPluginContext *pContext, const cell_t *params) {
+// Reads the cursor in params[1]. Returns NULL and throws an error if the
+// handle is invalid.
+static JanssonCursor *ReadCursor(IPluginContext *pContext, const cell_t *params) {
 	HandleError err;
 	HandleSecurity sec;
 	sec.pOwner = NULL;
 	sec.pIdentity = myself->GetIdentity();
 
-	// Param 1
-	json_t *object;
-	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
-	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+	JanssonCursor *cursor;
+	Handle_t hndlCursor = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlCursor, htJanssonCursor, &sec, (void **)&cursor)) != HandleError_None)
     {
-        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+        pContext->ThrowNativeError("Invalid <JSON Cursor> handle %x (error %d)", hndlCursor, err);
+        return NULL;
     }
 
-	return json_array_size(object);
+	return cursor;
 }
 
-//native Handle:json_array_get(Handle:hArray, iIndex);
-static cell_t Native_json_array_get(IPluginContext *pContext, const cell_t *params) {
+//native Handle:json_cursor(Handle:hObj);
+static cell_t Native_json_cursor(IPluginContext *pContext, const cell_t *params) {
 	HandleError err;
 	HandleSecurity sec;
 	sec.pOwner = NULL;
@@ -618,32 +995,205 @@ static cell_t Native_json_array_get(IPluginContext *pContext, const cell_t *para
 	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
 	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
     {
-        return pContext->ThrowNativeError("Invalid <Array> handle %x (error %d)", hndlObject, err);
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
     }
 
-	// Param 2
-	int iIndex = params[2];
-	json_t *result = json_array_get(object, iIndex);
-	if(result == NULL) {
+	if(!json_is_object(object)) {
 		return BAD_HANDLE;
 	}
 
-	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, result, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+	JanssonCursor *cursor = new JanssonCursor(object);
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonCursor, cursor, pContext->GetIdentity(), myself->GetIdentity(), NULL);
 	if(hndlResult == BAD_HANDLE) {
-		pContext->ThrowNativeError("Could not create handle for array element.");
-		return BAD_HANDLE;
+		delete cursor;
+		pContext->ThrowNativeError("Could not create handle for JSON Cursor.");
 	}
 
-	// result is a borrowed reference, we don't know what will happen with it
-	// so we increase the reference counter, which enforces the developer to
-	// CloseHandle() it.
-	json_incref(result);
-
 	return hndlResult;
 }
 
+//native bool:json_cursor_next(Handle:hCursor, String:sKey[]="", maxlength=0, &json_type:iType=JSON_NULL);
+static cell_t Native_json_cursor_next(IPluginContext *pContext, const cell_t *params) {
+	JanssonCursor *cursor = ReadCursor(pContext, params);
+	if(cursor == NULL || !cursor->Next()) {
+		return false;
+	}
 
-//native bool:json_array_set(Handle:hArray, iIndex, Handle:hValue);
+	// Param 2, 3
+	if(params[3] > 0) {
+		pContext->StringToLocalUTF8(params[2], params[3], cursor->GetKey(), NULL);
+	}
+
+	// Param 4
+	cell_t *type;
+	pContext->LocalToPhysAddr(params[4], &type);
+	*type = json_typeof(cursor->GetValue());
+
+	return true;
+}
+
+//native json_cursor_reset(Handle:hCursor);
+static cell_t Native_json_cursor_reset(IPluginContext *pContext, const cell_t *params) {
+	JanssonCursor *cursor = ReadCursor(pContext, params);
+	if(cursor == NULL) {
+		return 0;
+	}
+
+	cursor->Reset();
+	return 1;
+}
+
+//native Handle:json_cursor_value(Handle:hCursor);
+static cell_t Native_json_cursor_value(IPluginContext *pContext, const cell_t *params) {
+	JanssonCursor *cursor = ReadCursor(pContext, params);
+	if(cursor == NULL) {
+		return BAD_HANDLE;
+	}
+
+	json_t *value = cursor->GetValue();
+	if(value == NULL) {
+		return BAD_HANDLE;
+	}
+
+	// Same as json_object_get(), the plugin owns the new handle.
+	json_incref(value);
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, value, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		json_decref(value);
+		pContext->ThrowNativeError("Could not create <Object> handle.");
+	}
+
+	return hndlResult;
+}
+
+//native json_cursor_get_int(Handle:hCursor);
+static cell_t Native_json_cursor_get_int(IPluginContext *pContext, const cell_t *params) {
+	JanssonCursor *cursor = ReadCursor(pContext, params);
+	if(cursor == NULL) {
+		return 0;
+	}
+
+	json_t *value = cursor->GetValue();
+	if(!json_is_integer(value)) {
+		return 0;
+	}
+
+	return json_integer_value(value);
+}
+
+//native Float:json_cursor_get_float(Handle:hCursor);
+static cell_t Native_json_cursor_get_float(IPluginContext *pContext, const cell_t *params) {
+	JanssonCursor *cursor = ReadCursor(pContext, params);
+	if(cursor == NULL) {
+		return sp_ftoc(0.0f);
+	}
+
+	json_t *value = cursor->GetValue();
+	if(!json_is_number(value)) {
+		return sp_ftoc(0.0f);
+	}
+
+	return sp_ftoc(json_number_value(value));
+}
+
+//native bool:json_cursor_get_bool(Handle:hCursor);
+static cell_t Native_json_cursor_get_bool(IPluginContext *pContext, const cell_t *params) {
+	JanssonCursor *cursor = ReadCursor(pContext, params);
+	if(cursor == NULL) {
+		return false;
+	}
+
+	return json_is_true(cursor->GetValue());
+}
+
+//native json_cursor_get_string(Handle:hCursor, String:sBuffer[], maxlength);
+static cell_t Native_json_cursor_get_string(IPluginContext *pContext, const cell_t *params) {
+	JanssonCursor *cursor = ReadCursor(pContext, params);
+	if(cursor == NULL) {
+		return -1;
+	}
+
+	json_t *value = cursor->GetValue();
+	if(!json_is_string(value)) {
+		return -1;
+	}
+
+	const char *string = json_string_value(value);
+	pContext->StringToLocalUTF8(params[2], params[3], string, NULL);
+	return strlen(string);
+}
+
+//native Handle:json_array();
+static cell_t Native_json_array(IPluginContext *pContext, const cell_t *params) {
+	json_t *object = json_array();
+
+	Handle_t hndl = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndl == BAD_HANDLE) {
+		pContext->ThrowNativeError("Could not create <Array> handle.");
+	}
+
+	return hndl;
+}
+
+//native json_array_size(Handle:hArray);
+static cell_t Native_json_array_size(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	return json_array_size(object);
+}
+
+//native Handle:json_array_get(Handle:hArray, iIndex);
+static cell_t Native_json_array_get(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Array> handle %x (error %d)", hndlObject, err);
+    }
+
+	// Param 2
+	int iIndex = params[2];
+	json_t *result = json_array_get(object, iIndex);
+	if(result == NULL) {
+		return BAD_HANDLE;
+	}
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, result, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+	if(hndlResult == BAD_HANDLE) {
+		pContext->ThrowNativeError("Could not create handle for array element.");
+		return BAD_HANDLE;
+	}
+
+	// result is a borrowed reference, we don't know what will happen with it
+	// so we increase the reference counter, which enforces the developer to
+	// CloseHandle() it.
+	json_incref(result);
+
+	return hndlResult;
+}
+
+
+//native bool:json_array_set(Handle:hArray, iIndex, Handle:hValue);
 static cell_t Native_json_array_set(IPluginContext *pContext, const cell_t *params) {
 	HandleError err;
 	HandleSecurity sec;
@@ -903,6 +1453,250 @@ static cell_t Native_json_array_extend(IPluginContext *pContext, const cell_t *p
 	return (json_array_extend(object, other) == 0);
 }
 
+// Reads the array in params[1] and works out how many of its elements,
+// starting at params[start], fit into maxlength cells. Returns NULL and
+// throws an error if the handle or the start position is invalid.
+static json_t *ReadArraySlice(IPluginContext *pContext, const cell_t *params, int start, cell_t maxlength, size_t *count) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1: hArray
+	json_t *array;
+	Handle_t hndlArray = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlArray, htJanssonObject, &sec, (void **)&array)) != HandleError_None)
+    {
+        pContext->ThrowNativeError("Invalid <Array> handle %x (error %d)", hndlArray, err);
+        return NULL;
+    }
+
+	if(params[start] < 0) {
+		pContext->ThrowNativeError("Invalid start position %d", params[start]);
+		return NULL;
+	}
+
+	size_t size = json_array_size(array);
+	size_t first = params[start];
+
+	*count = 0;
+	if(first < size && maxlength > 0) {
+		*count = size - first;
+		if(*count > (size_t)maxlength) {
+			*count = maxlength;
+		}
+	}
+
+	return array;
+}
+
+// Appends count values of the given type ('i', 'f' or 's') from the plugin
+// array at local to array. Room for all of them is made up front. Returns
+// false and leaves array as it was if a value could not be added.
+static bool AppendValues(IPluginContext *pContext, json_t *array, cell_t local, cell_t count, char type) {
+	size_t size = json_array_size(array);
+	if(json_array_reserve(array, size + count) != 0) {
+		return false;
+	}
+
+	cell_t *values;
+	pContext->LocalToPhysAddr(local, &values);
+
+	for(cell_t i = 0; i < count; i++) {
+		json_t *value = NULL;
+		switch(type) {
+			case 'i':
+				value = json_integer(values[i]);
+				break;
+
+			case 'f':
+				value = json_real(sp_ctof(values[i]));
+				break;
+
+			case 's': {
+				// Each entry of the indirection vector holds the offset from
+				// the entry itself to its row.
+				char *string;
+				pContext->LocalToString(local + i * sizeof(cell_t) + values[i], &string);
+				value = json_string(string);
+				break;
+			}
+		}
+
+		if(json_array_append_new(array, value) != 0) {
+			while(json_array_size(array) > size) {
+				json_array_remove(array, json_array_size(array) - 1);
+			}
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Creates a new array from the plugin array in params[1] with params[2]
+// values of the given type.
+static cell_t CreateArrayFrom(IPluginContext *pContext, const cell_t *params, char type) {
+	if(params[2] < 0) {
+		return pContext->ThrowNativeError("Invalid count %d", params[2]);
+	}
+
+	json_t *array = json_array();
+	if(array == NULL || !AppendValues(pContext, array, params[1], params[2], type)) {
+		json_decref(array);
+		return BAD_HANDLE;
+	}
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, array, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		json_decref(array);
+		pContext->ThrowNativeError("Could not create <Array> handle.");
+	}
+
+	return hndlResult;
+}
+
+// Appends params[3] values of the given type from the plugin array in
+// params[2] to the array in params[1].
+static cell_t AppendArrayFrom(IPluginContext *pContext, const cell_t *params, char type) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1: hArray
+	json_t *array;
+	Handle_t hndlArray = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlArray, htJanssonObject, &sec, (void **)&array)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Array> handle %x (error %d)", hndlArray, err);
+    }
+
+	if(params[3] < 0) {
+		return pContext->ThrowNativeError("Invalid count %d", params[3]);
+	}
+
+	if(!json_is_array(array)) {
+		return 0;
+	}
+
+	return AppendValues(pContext, array, params[2], params[3], type);
+}
+
+//native Handle:json_array_from_ints(const iValues[], count);
+static cell_t Native_json_array_from_ints(IPluginContext *pContext, const cell_t *params) {
+	return CreateArrayFrom(pContext, params, 'i');
+}
+
+//native Handle:json_array_from_floats(const Float:fValues[], count);
+static cell_t Native_json_array_from_floats(IPluginContext *pContext, const cell_t *params) {
+	return CreateArrayFrom(pContext, params, 'f');
+}
+
+//native Handle:json_array_from_strings(const String:sValues[][], count);
+static cell_t Native_json_array_from_strings(IPluginContext *pContext, const cell_t *params) {
+	return CreateArrayFrom(pContext, params, 's');
+}
+
+//native bool:json_array_append_ints(Handle:hArray, const iValues[], count);
+static cell_t Native_json_array_append_ints(IPluginContext *pContext, const cell_t *params) {
+	return AppendArrayFrom(pContext, params, 'i');
+}
+
+//native bool:json_array_append_floats(Handle:hArray, const Float:fValues[], count);
+static cell_t Native_json_array_append_floats(IPluginContext *pContext, const cell_t *params) {
+	return AppendArrayFrom(pContext, params, 'f');
+}
+
+//native bool:json_array_append_strings(Handle:hArray, const String:sValues[][], count);
+static cell_t Native_json_array_append_strings(IPluginContext *pContext, const cell_t *params) {
+	return AppendArrayFrom(pContext, params, 's');
+}
+
+//native json_array_get_ints(Handle:hArray, iValues[], maxlength, iStart=0);
+static cell_t Native_json_array_get_ints(IPluginContext *pContext, const cell_t *params) {
+	size_t count;
+	json_t *array = ReadArraySlice(pContext, params, 4, params[3], &count);
+	if(array == NULL) {
+		return 0;
+	}
+
+	// Param 2: iValues
+	cell_t *values;
+	pContext->LocalToPhysAddr(params[2], &values);
+
+	for(size_t i = 0; i < count; i++) {
+		json_t *element = json_array_get(array, params[4] + i);
+		values[i] = json_is_integer(element) ? json_integer_value(element) : 0;
+	}
+
+	return count;
+}
+
+//native json_array_get_floats(Handle:hArray, Float:fValues[], maxlength, iStart=0);
+static cell_t Native_json_array_get_floats(IPluginContext *pContext, const cell_t *params) {
+	size_t count;
+	json_t *array = ReadArraySlice(pContext, params, 4, params[3], &count);
+	if(array == NULL) {
+		return 0;
+	}
+
+	// Param 2: fValues
+	cell_t *values;
+	pContext->LocalToPhysAddr(params[2], &values);
+
+	for(size_t i = 0; i < count; i++) {
+		json_t *element = json_array_get(array, params[4] + i);
+		values[i] = sp_ftoc(json_is_number(element) ? json_number_value(element) : 0.0f);
+	}
+
+	return count;
+}
+
+//native json_array_get_bools(Handle:hArray, bool:bValues[], maxlength, iStart=0);
+static cell_t Native_json_array_get_bools(IPluginContext *pContext, const cell_t *params) {
+	size_t count;
+	json_t *array = ReadArraySlice(pContext, params, 4, params[3], &count);
+	if(array == NULL) {
+		return 0;
+	}
+
+	// Param 2: bValues
+	cell_t *values;
+	pContext->LocalToPhysAddr(params[2], &values);
+
+	for(size_t i = 0; i < count; i++) {
+		values[i] = json_is_true(json_array_get(array, params[4] + i));
+	}
+
+	return count;
+}
+
+//native json_array_get_strings(Handle:hArray, String:sValues[][], maxstrings, maxlength, iStart=0);
+static cell_t Native_json_array_get_strings(IPluginContext *pContext, const cell_t *params) {
+	size_t count;
+	json_t *array = ReadArraySlice(pContext, params, 5, params[3], &count);
+	if(array == NULL) {
+		return 0;
+	}
+
+	// Param 2: sValues, each entry of the indirection vector holds the
+	// offset from the entry itself to its row.
+	cell_t *rows;
+	pContext->LocalToPhysAddr(params[2], &rows);
+
+	for(size_t i = 0; i < count; i++) {
+		json_t *element = json_array_get(array, params[5] + i);
+		const char *value = json_is_string(element) ? json_string_value(element) : "";
+
+		cell_t row = params[2] + i * sizeof(cell_t) + rows[i];
+		pContext->StringToLocalUTF8(row, params[4], value, NULL);
+	}
+
+	return count;
+}
+
 //native json_typeof(Handle:hObj);
 static cell_t Native_json_typeof(IPluginContext *pContext, const cell_t *params) {
 	HandleError err;
@@ -1202,53 +1996,210 @@ static cell_t Native_json_integer_set(IPluginContext *pContext, const cell_t *pa
 	return (json_integer_set(object, params[2]) == 0);
 }
 
-//native json_real(Float:value);
-static cell_t Native_json_real(IPluginContext *pContext, const cell_t *params) {
-	json_t *result = json_real(sp_ctof(params[1]));
+// 64-bit integers are passed to plugins as int[2], low word first.
+static json_int_t CellsToInteger(const cell_t *cells) {
+	return (json_int_t)(((unsigned long long)(uint32_t)cells[1] << 32) | (uint32_t)cells[0]);
+}
+
+static void IntegerToCells(json_int_t value, cell_t *cells) {
+	cells[0] = (cell_t)(uint32_t)((unsigned long long)value & 0xFFFFFFFF);
+	cells[1] = (cell_t)(uint32_t)((unsigned long long)value >> 32);
+}
+
+// Same as in jansson's load.c
+#if JSON_INTEGER_IS_LONG_LONG
+#ifdef _MSC_VER
+#define json_strtoint	_strtoi64
+#else
+#define json_strtoint	strtoll
+#endif
+#else
+#define json_strtoint	strtol
+#endif
+
+// Parses all of string as a decimal integer. Returns false if there is
+// anything else in it or the value does not fit into json_int_t.
+static bool ParseInteger(const char *string, json_int_t *value) {
+	if(*string != '-' && (*string < '0' || *string > '9')) {
+		return false;
+	}
+
+	char *end;
+	errno = 0;
+	json_int_t result = json_strtoint(string, &end, 10);
+	if(errno == ERANGE || end == string || *end != '\0') {
+		return false;
+	}
+
+	*value = result;
+	return true;
+}
+
+// Individual accounts in the public universe, see json_steamid().
+#define STEAMID64_INDIVIDUAL_BASE	0x0110000100000000LL
+
+static cell_t CreateIntegerHandle(IPluginContext *pContext, json_int_t value) {
+	json_t *result = json_integer(value);
 
 	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, result, pContext->GetIdentity(), myself->GetIdentity(), NULL);
 
 	if(hndlResult == BAD_HANDLE) {
-		pContext->ThrowNativeError("Could not create <Real> handle.");
+		json_decref(result);
+		pContext->ThrowNativeError("Could not create <Integer> handle.");
 	}
 
 	return hndlResult;
 }
 
-//native Float:json_real_value(Handle:hInteger);
-static cell_t Native_json_real_value(IPluginContext *pContext, const cell_t *params) {
+// Reads the integer in params[1]. Returns false and throws an error if the
+// handle is invalid, *result is NULL if it is not a JSON integer.
+static bool ReadInteger(IPluginContext *pContext, const cell_t *params, json_t **result) {
 	HandleError err;
 	HandleSecurity sec;
 	sec.pOwner = NULL;
 	sec.pIdentity = myself->GetIdentity();
 
-	// Param 1
 	json_t *object;
 	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
 	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
     {
-        return pContext->ThrowNativeError("Invalid <Real> handle %x (error %d)", hndlObject, err);
+        pContext->ThrowNativeError("Invalid <Integer> handle %x (error %d)", hndlObject, err);
+        return false;
     }
 
-	return sp_ftoc(json_real_value(object));
+	*result = json_is_integer(object) ? object : NULL;
+	return true;
 }
 
-//native json_real_set(Handle:hFloat, Float:value);
-static cell_t Native_json_real_set(IPluginContext *pContext, const cell_t *params) {
-	HandleError err;
-	HandleSecurity sec;
-	sec.pOwner = NULL;
-	sec.pIdentity = myself->GetIdentity();
-
-	// Param 1
-	json_t *object;
-	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
-	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
-    {
-        return pContext->ThrowNativeError("Invalid <Real> handle %x (error %d)", hndlObject, err);
-    }
+//native Handle:json_integer64(const iValue[2]);
+static cell_t Native_json_integer64(IPluginContext *pContext, const cell_t *params) {
+	cell_t *cells;
+	pContext->LocalToPhysAddr(params[1], &cells);
 
-	return (json_real_set(object, sp_ctof(params[2])) == 0);
+	return CreateIntegerHandle(pContext, CellsToInteger(cells));
+}
+
+//native bool:json_integer64_value(Handle:hInteger, iValue[2]);
+static cell_t Native_json_integer64_value(IPluginContext *pContext, const cell_t *params) {
+	json_t *object;
+	if(!ReadInteger(pContext, params, &object)) {
+		return false;
+	}
+
+	cell_t *cells;
+	pContext->LocalToPhysAddr(params[2], &cells);
+	IntegerToCells(json_integer_value(object), cells);
+
+	return object != NULL;
+}
+
+//native bool:json_integer64_set(Handle:hInteger, const iValue[2]);
+static cell_t Native_json_integer64_set(IPluginContext *pContext, const cell_t *params) {
+	json_t *object;
+	if(!ReadInteger(pContext, params, &object)) {
+		return false;
+	}
+
+	cell_t *cells;
+	pContext->LocalToPhysAddr(params[2], &cells);
+
+	return (json_integer_set(object, CellsToInteger(cells)) == 0);
+}
+
+//native Handle:json_integer_from_string(const String:sValue[]);
+static cell_t Native_json_integer_from_string(IPluginContext *pContext, const cell_t *params) {
+	char *string;
+	pContext->LocalToString(params[1], &string);
+
+	json_int_t value;
+	if(!ParseInteger(string, &value)) {
+		return BAD_HANDLE;
+	}
+
+	return CreateIntegerHandle(pContext, value);
+}
+
+//native json_integer_to_string(Handle:hInteger, String:sBuffer[], maxlength);
+static cell_t Native_json_integer_to_string(IPluginContext *pContext, const cell_t *params) {
+	json_t *object;
+	if(!ReadInteger(pContext, params, &object) || object == NULL) {
+		return -1;
+	}
+
+	char buffer[32];
+	int length = snprintf(buffer, sizeof(buffer), "%" JSON_INTEGER_FORMAT, json_integer_value(object));
+	pContext->StringToLocalUTF8(params[2], params[3], buffer, NULL);
+
+	return length;
+}
+
+//native Handle:json_steamid(iAccountID);
+static cell_t Native_json_steamid(IPluginContext *pContext, const cell_t *params) {
+	return CreateIntegerHandle(pContext, STEAMID64_INDIVIDUAL_BASE + (uint32_t)params[1]);
+}
+
+//native json_steamid_account(Handle:hInteger);
+static cell_t Native_json_steamid_account(IPluginContext *pContext, const cell_t *params) {
+	json_t *object;
+	if(!ReadInteger(pContext, params, &object) || object == NULL) {
+		return 0;
+	}
+
+	json_int_t value = json_integer_value(object);
+	if((value >> 32) != (STEAMID64_INDIVIDUAL_BASE >> 32)) {
+		return 0;
+	}
+
+	return (cell_t)(uint32_t)(value & 0xFFFFFFFF);
+}
+
+//native json_real(Float:value);
+static cell_t Native_json_real(IPluginContext *pContext, const cell_t *params) {
+	json_t *result = json_real(sp_ctof(params[1]));
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, result, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		pContext->ThrowNativeError("Could not create <Real> handle.");
+	}
+
+	return hndlResult;
+}
+
+//native Float:json_real_value(Handle:hInteger);
+static cell_t Native_json_real_value(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Real> handle %x (error %d)", hndlObject, err);
+    }
+
+	return sp_ftoc(json_real_value(object));
+}
+
+//native json_real_set(Handle:hFloat, Float:value);
+static cell_t Native_json_real_set(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Real> handle %x (error %d)", hndlObject, err);
+    }
+
+	return (json_real_set(object, sp_ctof(params[2])) == 0);
 }
 
 //native Float:json_number_value(Handle:hNumber);
@@ -1258,28 +2209,892 @@ static cell_t Native_json_number_value(IPluginContext *pContext, const cell_t *p
 	sec.pOwner = NULL;
 	sec.pIdentity = myself->GetIdentity();
 
-	// Param 1
-	json_t *object;
-	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
-	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
-    {
-        return pContext->ThrowNativeError("Invalid <Real> handle %x (error %d)", hndlObject, err);
-    }
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Real> handle %x (error %d)", hndlObject, err);
+    }
+
+	return sp_ftoc(json_number_value(object));
+}
+
+// Resolves the JSON Pointer in params[2] against the value in params[1].
+// Returns false if the handle is invalid, an error has been thrown then.
+// *result is NULL if the path does not exist.
+static bool ResolvePath(IPluginContext *pContext, const cell_t *params, json_t **result) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+        return false;
+    }
+
+	// Param 2
+	char *path;
+	pContext->LocalToString(params[2], &path);
+
+	*result = json_path_get(object, path);
+	return true;
+}
+
+//native Handle:json_path_get(Handle:hObj, const String:sPath[]);
+static cell_t Native_json_path_get(IPluginContext *pContext, const cell_t *params) {
+	json_t *result;
+	if(!ResolvePath(pContext, params, &result) || result == NULL) {
+		return BAD_HANDLE;
+	}
+
+	// Same as json_object_get(), the plugin owns the new handle.
+	json_incref(result);
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, result, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		pContext->ThrowNativeError("Could not create <Object> handle.");
+	}
+
+	return hndlResult;
+}
+
+//native json_path_get_int(Handle:hObj, const String:sPath[]);
+static cell_t Native_json_path_get_int(IPluginContext *pContext, const cell_t *params) {
+	json_t *result;
+	if(!ResolvePath(pContext, params, &result) || !json_is_integer(result)) {
+		return 0;
+	}
+
+	return json_integer_value(result);
+}
+
+//native Float:json_path_get_float(Handle:hObj, const String:sPath[]);
+static cell_t Native_json_path_get_float(IPluginContext *pContext, const cell_t *params) {
+	json_t *result;
+	if(!ResolvePath(pContext, params, &result) || !json_is_number(result)) {
+		return sp_ftoc(0.0f);
+	}
+
+	return sp_ftoc(json_number_value(result));
+}
+
+//native bool:json_path_get_bool(Handle:hObj, const String:sPath[]);
+static cell_t Native_json_path_get_bool(IPluginContext *pContext, const cell_t *params) {
+	json_t *result;
+	if(!ResolvePath(pContext, params, &result)) {
+		return 0;
+	}
+
+	return json_is_true(result);
+}
+
+//native json_path_get_string(Handle:hObj, const String:sPath[], String:sBuffer[], maxlength);
+static cell_t Native_json_path_get_string(IPluginContext *pContext, const cell_t *params) {
+	json_t *result;
+	if(!ResolvePath(pContext, params, &result) || !json_is_string(result)) {
+		return -1;
+	}
+
+	const char *value = json_string_value(result);
+	pContext->StringToLocalUTF8(params[3], params[4], value, NULL);
+	return strlen(value);
+}
+
+// Stores value at the JSON Pointer in params[2] inside params[1], creating
+// missing objects and arrays if params[4] is set. Steals the reference to
+// value.
+static cell_t StorePath(IPluginContext *pContext, const cell_t *params, json_t *value) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+		json_decref(value);
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	// Param 2
+	char *path;
+	pContext->LocalToString(params[2], &path);
+
+	size_t flags = 0;
+	if(params[4] == 1) {						// Param 4: bCreateMissing
+		flags = flags | JSON_PATH_CREATE;
+	}
+
+	return (json_path_set_new(object, path, value, flags) == 0);
+}
+
+//native bool:json_path_set_int(Handle:hObj, const String:sPath[], iValue, bool:bCreateMissing = false);
+static cell_t Native_json_path_set_int(IPluginContext *pContext, const cell_t *params) {
+	return StorePath(pContext, params, json_integer(params[3]));
+}
+
+//native bool:json_path_set_float(Handle:hObj, const String:sPath[], Float:fValue, bool:bCreateMissing = false);
+static cell_t Native_json_path_set_float(IPluginContext *pContext, const cell_t *params) {
+	return StorePath(pContext, params, json_real(sp_ctof(params[3])));
+}
+
+//native bool:json_path_set_bool(Handle:hObj, const String:sPath[], bool:bValue, bool:bCreateMissing = false);
+static cell_t Native_json_path_set_bool(IPluginContext *pContext, const cell_t *params) {
+	return StorePath(pContext, params, json_boolean(params[3]));
+}
+
+//native bool:json_path_set_string(Handle:hObj, const String:sPath[], const String:sValue[], bool:bCreateMissing = false);
+static cell_t Native_json_path_set_string(IPluginContext *pContext, const cell_t *params) {
+	char *value;
+	pContext->LocalToString(params[3], &value);
+
+	return StorePath(pContext, params, json_string(value));
+}
+
+//native bool:json_path_set_value(Handle:hObj, const String:sPath[], Handle:hValue, bool:bCreateMissing = false);
+static cell_t Native_json_path_set_value(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 3
+	json_t *value;
+	Handle_t hndlValue = static_cast<Handle_t>(params[3]);
+	if ((err=g_pHandleSys->ReadHandle(hndlValue, htJanssonObject, &sec, (void **)&value)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlValue, err);
+    }
+
+	return StorePath(pContext, params, json_incref(value));
+}
+
+//native Handle:json_view(Handle:hObj);
+static cell_t Native_json_view(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	JanssonView *view = new JanssonView(object);
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonView, view, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		delete view;
+		pContext->ThrowNativeError("Could not create <JSON View> handle.");
+	}
+
+	return hndlResult;
+}
+
+// Reads the view in params[1]. Returns NULL and throws an error if the
+// handle is invalid.
+static JanssonView *ReadView(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	JanssonView *view;
+	Handle_t hndlView = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlView, htJanssonView, &sec, (void **)&view)) != HandleError_None)
+    {
+        pContext->ThrowNativeError("Invalid <JSON View> handle %x (error %d)", hndlView, err);
+        return NULL;
+    }
+
+	return view;
+}
+
+// Resolves the node reference in params[2] against the view in params[1].
+// Returns NULL and throws an error if either of them is invalid.
+static json_t *ReadViewNode(IPluginContext *pContext, const cell_t *params, JanssonView **result) {
+	JanssonView *view = ReadView(pContext, params);
+	if(view == NULL) {
+		return NULL;
+	}
+
+	json_t *node = view->Resolve(params[2]);
+	if(node == NULL) {
+		pContext->ThrowNativeError("Invalid or stale view node %x", params[2]);
+		return NULL;
+	}
+
+	if(result != NULL) {
+		*result = view;
+	}
+
+	return node;
+}
+
+// Adds a child of a view node, a missing child is reported as -1.
+static cell_t AddViewNode(IPluginContext *pContext, JanssonView *view, json_t *value) {
+	if(value == NULL) {
+		return -1;
+	}
+
+	cell_t node = view->Add(value);
+	if(node == -1) {
+		pContext->ThrowNativeError("JSON View is full, use json_view_reset().");
+	}
+
+	return node;
+}
+
+//native json_view_reset(Handle:hView);
+static cell_t Native_json_view_reset(IPluginContext *pContext, const cell_t *params) {
+	JanssonView *view = ReadView(pContext, params);
+	if(view == NULL) {
+		return 0;
+	}
+
+	view->Reset();
+	return 1;
+}
+
+//native json_view_object_get(Handle:hView, iNode, const String:sKey[]);
+static cell_t Native_json_view_object_get(IPluginContext *pContext, const cell_t *params) {
+	JanssonView *view;
+	json_t *node = ReadViewNode(pContext, params, &view);
+	if(node == NULL) {
+		return -1;
+	}
+
+	// Param 3
+	char *key;
+	pContext->LocalToString(params[3], &key);
+
+	return AddViewNode(pContext, view, json_object_get(node, key));
+}
+
+//native json_view_object_get_key(Handle:hView, iNode, iKey);
+static cell_t Native_json_view_object_get_key(IPluginContext *pContext, const cell_t *params) {
+	JanssonView *view;
+	json_t *node = ReadViewNode(pContext, params, &view);
+	if(node == NULL) {
+		return -1;
+	}
+
+	// Param 3
+	json_key_t *key = ReadKey(pContext, params[3]);
+	if(key == NULL) {
+		return -1;
+	}
+
+	return AddViewNode(pContext, view, json_object_get_key(node, key));
+}
+
+//native json_view_array_get(Handle:hView, iNode, iIndex);
+static cell_t Native_json_view_array_get(IPluginContext *pContext, const cell_t *params) {
+	JanssonView *view;
+	json_t *node = ReadViewNode(pContext, params, &view);
+	if(node == NULL) {
+		return -1;
+	}
+
+	return AddViewNode(pContext, view, json_array_get(node, params[3]));
+}
+
+//native json_view_path_get(Handle:hView, iNode, const String:sPath[]);
+static cell_t Native_json_view_path_get(IPluginContext *pContext, const cell_t *params) {
+	JanssonView *view;
+	json_t *node = ReadViewNode(pContext, params, &view);
+	if(node == NULL) {
+		return -1;
+	}
+
+	// Param 3
+	char *path;
+	pContext->LocalToString(params[3], &path);
+
+	return AddViewNode(pContext, view, json_path_get(node, path));
+}
+
+//native json_type:json_view_typeof(Handle:hView, iNode);
+static cell_t Native_json_view_typeof(IPluginContext *pContext, const cell_t *params) {
+	json_t *node = ReadViewNode(pContext, params, NULL);
+	if(node == NULL) {
+		return JSON_NULL;
+	}
+
+	return json_typeof(node);
+}
+
+//native json_view_size(Handle:hView, iNode);
+static cell_t Native_json_view_size(IPluginContext *pContext, const cell_t *params) {
+	json_t *node = ReadViewNode(pContext, params, NULL);
+	if(node == NULL) {
+		return -1;
+	}
+
+	if(json_is_object(node)) {
+		return json_object_size(node);
+	}
+
+	if(json_is_array(node)) {
+		return json_array_size(node);
+	}
+
+	return -1;
+}
+
+//native json_view_get_int(Handle:hView, iNode);
+static cell_t Native_json_view_get_int(IPluginContext *pContext, const cell_t *params) {
+	json_t *node = ReadViewNode(pContext, params, NULL);
+	if(!json_is_integer(node)) {
+		return 0;
+	}
+
+	return json_integer_value(node);
+}
+
+//native Float:json_view_get_float(Handle:hView, iNode);
+static cell_t Native_json_view_get_float(IPluginContext *pContext, const cell_t *params) {
+	json_t *node = ReadViewNode(pContext, params, NULL);
+	if(!json_is_number(node)) {
+		return sp_ftoc(0.0f);
+	}
+
+	return sp_ftoc(json_number_value(node));
+}
+
+//native bool:json_view_get_bool(Handle:hView, iNode);
+static cell_t Native_json_view_get_bool(IPluginContext *pContext, const cell_t *params) {
+	json_t *node = ReadViewNode(pContext, params, NULL);
+	return json_is_true(node);
+}
+
+//native json_view_get_string(Handle:hView, iNode, String:sBuffer[], maxlength);
+static cell_t Native_json_view_get_string(IPluginContext *pContext, const cell_t *params) {
+	json_t *node = ReadViewNode(pContext, params, NULL);
+	if(!json_is_string(node)) {
+		return -1;
+	}
+
+	const char *value = json_string_value(node);
+	pContext->StringToLocalUTF8(params[3], params[4], value, NULL);
+	return strlen(value);
+}
+
+//native Handle:json_view_get(Handle:hView, iNode);
+static cell_t Native_json_view_get(IPluginContext *pContext, const cell_t *params) {
+	json_t *node = ReadViewNode(pContext, params, NULL);
+	if(node == NULL) {
+		return BAD_HANDLE;
+	}
+
+	// Same as json_object_get(), the plugin owns the new handle.
+	json_incref(node);
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, node, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		json_decref(node);
+		pContext->ThrowNativeError("Could not create <Object> handle.");
+	}
+
+	return hndlResult;
+}
+
+//native Handle:json_load(const String:sJSON[]);
+static cell_t Native_json_load(IPluginContext *pContext, const cell_t *params) {
+	// Param 1
+	char *sJSON;
+	pContext->LocalToString(params[1], &sJSON);
+
+    json_error_t error;
+    json_t *object = json_loads(sJSON, 0, &error);
+	if(!object) {
+		g_pSM->LogError(myself, "Error in line %d, col %d: %s", error.line, error.column, error.text);
+		return BAD_HANDLE;
+	}
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		pContext->ThrowNativeError("Could not create <Object> handle.");
+	}
+
+	return hndlResult;
+}
+
+//native Handle:json_load_ex(const String:sJSON[], String:sErrorText[], maxlen, &iLine, &iColumn, bool:bArena = false);
+static cell_t Native_json_load_ex(IPluginContext *pContext, const cell_t *params) {
+	// Param 1
+	char *sJSON;
+	pContext->LocalToString(params[1], &sJSON);
+
+	// Param 6: bArena, missing in plugins compiled against older includes
+	size_t flags = 0;
+	if(params[0] >= 6 && params[6] == 1) {
+		flags = flags | JSON_ARENA_ALLOC;
+	}
+
+    json_error_t error;
+    json_t *object = json_loads(sJSON, flags, &error);
+	if(!object) {
+		pContext->StringToLocalUTF8(params[2], params[3], error.text, NULL);
+
+		cell_t *pLineValue;
+		pContext->LocalToPhysAddr(params[4], &pLineValue);
+		*pLineValue = error.line;
+
+		cell_t *pColumnValue;		
+		pContext->LocalToPhysAddr(params[5], &pColumnValue);		
+		*pColumnValue = error.column;
+
+		return BAD_HANDLE;
+	}
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		pContext->ThrowNativeError("Could not create <Object> handle.");
+	}
+
+	return hndlResult;
+}
+
+
+//native Handle:json_load_file(const String:sFilePath[PLATFORM_MAX_PATH]);
+static cell_t Native_json_load_file(IPluginContext *pContext, const cell_t *params) {
+	// Param 1
+	char *jsonfile;
+	pContext->LocalToString(params[1], &jsonfile);
+
+	char filePath[PLATFORM_MAX_PATH];
+	g_pSM->BuildPath(Path_Game, filePath, sizeof(filePath), jsonfile);
+
+    json_error_t error;
+    json_t *object = json_load_file(filePath, 0, &error);
+	if(!object) {
+		g_pSM->LogError(myself, "Error in line %d, col %d: %s", error.line, error.column, error.text);
+		return BAD_HANDLE;
+	}
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		pContext->ThrowNativeError("Could not create <Object> handle.");
+	}
+
+	return hndlResult;
+}
+
+// Files that dump jobs are writing to. Jobs are created and deleted on the
+// main thread, so this is only ever touched there.
+static std::multiset<std::string> g_WritingFiles;
+
+//native Handle:json_load_file_ex(const String:sFilePath[PLATFORM_MAX_PATH], String:sErrorText[], maxlen, &iLine, &iColumn, bool:bMemoryMap = false, bool:bArena = false);
+static cell_t Native_json_load_file_ex(IPluginContext *pContext, const cell_t *params) {
+	// Param 1
+	char *jsonfile;
+	pContext->LocalToString(params[1], &jsonfile);
+
+	char filePath[PLATFORM_MAX_PATH];
+	g_pSM->BuildPath(Path_Game, filePath, sizeof(filePath), jsonfile);
+
+	// Param 6: bMemoryMap, missing in plugins compiled against older includes
+	// A mapped file that is truncated while it is parsed crashes the server,
+	// so files that a dump job is rewriting are read the normal way.
+	size_t flags = 0;
+	if(params[0] >= 6 && params[6] == 1 && g_WritingFiles.count(filePath) == 0) {
+		flags = flags | JSON_MAP_FILE;
+	}
+
+	// Param 7: bArena
+	if(params[0] >= 7 && params[7] == 1) {
+		flags = flags | JSON_ARENA_ALLOC;
+	}
+
+    json_error_t error;
+    json_t *object = json_load_file(filePath, flags, &error);
+	if(!object) {
+		pContext->StringToLocalUTF8(params[2], params[3], error.text, NULL);
+
+		cell_t *pLineValue;
+		pContext->LocalToPhysAddr(params[4], &pLineValue);
+		*pLineValue = error.line;
+
+		cell_t *pColumnValue;		
+		pContext->LocalToPhysAddr(params[5], &pColumnValue);		
+		*pColumnValue = error.column;
+
+		return BAD_HANDLE;
+	}
+
+	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+
+	if(hndlResult == BAD_HANDLE) {
+		pContext->ThrowNativeError("Could not create <Object> handle.");
+	}
+
+	return hndlResult;
+}
+
+// Output sink for json_dump_callback() that writes straight into a plugin
+// buffer. Everything past maxlength is only counted, so the caller learns
+// the size it would have needed.
+struct JanssonBufferSink {
+	char *buffer;
+	size_t maxlength;
+	size_t length;
+};
+
+static int DumpToBuffer(const char *buffer, size_t size, void *data) {
+	JanssonBufferSink *sink = (JanssonBufferSink *)data;
+	if(sink->length < sink->maxlength) {
+		size_t count = sink->maxlength - sink->length;
+		if(count > size) {
+			count = size;
+		}
+
+		memcpy(sink->buffer + sink->length, buffer, count);
+	}
+
+	sink->length += size;
+	return 0;
+}
+
+static void TerminateBufferSink(JanssonBufferSink *sink) {
+	if(sink->maxlength == 0) {
+		return;
+	}
+
+	if(sink->length < sink->maxlength) {
+		sink->buffer[sink->length] = '\0';
+		return;
+	}
+
+	// Truncated: cut in front of the last UTF-8 sequence that didn't fit
+	// completely, just like StringToLocalUTF8() would.
+	size_t end = sink->maxlength - 1;
+	while(end > 0 && (sink->buffer[end] & 0xC0) == 0x80) {
+		end--;
+	}
+
+	sink->buffer[end] = '\0';
+}
+
+//native json_dump(Handle:hObject, String:sJSON[], maxlength, iIndentWidth = 4, bool:bEnsureAscii = false, bool:bSortKeys = false, bool:bPreserveOrder = false);
+static cell_t Native_json_dump(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	size_t flags = JSON_INDENT(params[4]);		// Param 4: iIndentWidth
+	if(params[5] == 1) {						// Param 5: bEnsureAscii
+		flags = flags | JSON_ENSURE_ASCII;
+	}
+
+	if(params[6] == 1) {						// Param 6: bSortKeys
+		flags = flags | JSON_SORT_KEYS;
+	}
+
+	if(params[7] == 1) {						// Param 7: bPreserveOrder
+		flags = flags | JSON_PRESERVE_ORDER;
+	}
+
+	// Param 2, 3: Serialize directly into the plugin's buffer
+	JanssonBufferSink sink;
+	pContext->LocalToString(params[2], &sink.buffer);
+	sink.maxlength = params[3] > 0 ? params[3] : 0;
+	sink.length = 0;
+
+	// Return
+	if(json_dump_callback(object, &DumpToBuffer, &sink, flags) != 0) {
+		if(sink.maxlength > 0) {
+			sink.buffer[0] = '\0';
+		}
+
+		return -1;
+	}
+
+	TerminateBufferSink(&sink);
+	return sink.length;
+}
+
+//native json_dump_size(Handle:hObject, iIndentWidth = 4, bool:bEnsureAscii = false);
+static cell_t Native_json_dump_size(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	size_t flags = JSON_INDENT(params[2]);		// Param 2: iIndentWidth
+	if(params[3] == 1) {						// Param 3: bEnsureAscii
+		flags = flags | JSON_ENSURE_ASCII;
+	}
+
+	// Return, a valid encoding is never empty
+	size_t size = json_dump_size(object, flags);
+	if(size == 0) {
+		return -1;
+	}
+
+	return size;
+}
+
+//native bool:json_dump_file(Handle:hObject, const String:sFilePath[], iIndentWidth = 4, bool:bEnsureAscii = false, bool:bSortKeys = false, bool:bPreserveOrder = false);
+static cell_t Native_json_dump_file(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	// Param 2
+	char *jsonfile;
+	pContext->LocalToString(params[2], &jsonfile);
+	
+	char filePath[PLATFORM_MAX_PATH];
+	g_pSM->BuildPath(Path_Game, filePath, sizeof(filePath), jsonfile);
+
+
+	size_t flags = JSON_INDENT(params[3]);		// Param 3: iIndentWidth
+	if(params[4] == 1) {						// Param 4: bEnsureAscii
+		flags = flags | JSON_ENSURE_ASCII;
+	}
+
+	if(params[5] == 1) {						// Param 5: bSortKeys
+		flags = flags | JSON_SORT_KEYS;
+	}
+
+	if(params[6] == 1) {						// Param 6: bPreserveOrder
+		flags = flags | JSON_PRESERVE_ORDER;
+	}
+
+	// Return
+	bool bSuccess = (json_dump_file(object, filePath, flags) == 0);
+	return bSuccess;
+}
+
+/**
+ * json_pack_args() / json_unpack()
+ *
+ * Pawn can't hand us a va_list, so the arguments are fed to jansson one at
+ * a time through json_pack_callback() and json_unpack_callback(). Variadic
+ * Pawn arguments are always passed by reference, so every cell is read
+ * through its address.
+ */
+struct PawnPackArgs {
+	IPluginContext *pContext;
+	const cell_t *params;
+	int next;						// Index of the next unused param
+	HandleSecurity sec;
+	std::vector<Handle_t> stolen;	// Handles consumed by 'o'
+};
+
+static int PackNextArg(char type, json_arg_t *arg, void *data) {
+	PawnPackArgs *args = (PawnPackArgs *)data;
+	if(args->next > args->params[0]) {
+		return -1;
+	}
+
+	cell_t param = args->params[args->next++];
+	if(type == 's') {
+		char *str;
+		args->pContext->LocalToString(param, &str);
+		arg->string = str;
+		return 0;
+	}
+
+	cell_t *value;
+	if(args->pContext->LocalToPhysAddr(param, &value) != SP_ERROR_NONE) {
+		return -1;
+	}
+
+	switch(type) {
+		case 'b':
+		case 'i':
+		case '#':
+			arg->integer = *value;
+			return 0;
+
+		case 'I':
+			arg->json_int = *value;
+			return 0;
+
+		case 'f':
+			arg->real = sp_ctof(*value);
+			return 0;
+
+		case 'O':
+		case 'o': {
+			json_t *json;
+			Handle_t hndlValue = static_cast<Handle_t>(*value);
+			if(g_pHandleSys->ReadHandle(hndlValue, htJanssonObject, &args->sec, (void **)&json) != HandleError_None) {
+				return -1;
+			}
+
+			// The handle keeps its reference until packing has succeeded
+			if(type == 'o') {
+				json_incref(json);
+				args->stolen.push_back(hndlValue);
+			}
+
+			arg->json = json;
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+// Unpacked values are collected here and only copied back to the plugin
+// if the whole format matched.
+struct PawnUnpackTarget {
+	char type;
+	cell_t *addr;
+	cell_t local;					// 's': buffer address
+	cell_t maxlength;				// 's': buffer size
+	union {
+		const char *string;
+		int integer;
+		json_int_t json_int;
+		double real;
+		json_t *json;
+	} value;
+};
+
+struct PawnUnpackArgs {
+	IPluginContext *pContext;
+	const cell_t *params;
+	int next;
+	std::deque<PawnUnpackTarget> targets;	// Keeps addresses stable
+};
+
+static int UnpackNextArg(char type, json_arg_t *arg, void *data) {
+	PawnUnpackArgs *args = (PawnUnpackArgs *)data;
+	if(args->next > args->params[0]) {
+		return -1;
+	}
+
+	cell_t param = args->params[args->next++];
+	if(type == 'k') {
+		char *key;
+		args->pContext->LocalToString(param, &key);
+		arg->string = key;
+		return 0;
+	}
+
+	PawnUnpackTarget target;
+	target.type = type;
+	if(args->pContext->LocalToPhysAddr(param, &target.addr) != SP_ERROR_NONE) {
+		return -1;
+	}
+
+	// Missing optional keys leave a target untouched, so it starts out
+	// with whatever the plugin variable already holds.
+	switch(type) {
+		case 's': {
+			cell_t *maxlength;
+			if(args->next > args->params[0] ||
+			   args->pContext->LocalToPhysAddr(args->params[args->next++], &maxlength) != SP_ERROR_NONE) {
+				return -1;
+			}
+
+			target.local = param;
+			target.maxlength = *maxlength;
+			target.value.string = NULL;
+			break;
+		}
+
+		case 'b':
+		case 'i':
+			target.value.integer = *target.addr;
+			break;
+
+		case 'I':
+			target.value.json_int = *target.addr;
+			break;
+
+		case 'f':
+		case 'F':
+			target.value.real = sp_ctof(*target.addr);
+			break;
+
+		case 'O':
+		case 'o':
+			target.value.json = NULL;
+			break;
+
+		default:
+			return -1;
+	}
 
-	return sp_ftoc(json_number_value(object));
+	args->targets.push_back(target);
+	arg->target = &args->targets.back().value;
+	return 0;
 }
 
-//native Handle:json_load(const String:sJSON[]);
-static cell_t Native_json_load(IPluginContext *pContext, const cell_t *params) {
+//native Handle:json_pack_args(const String:sFormat[], any:...);
+static cell_t Native_json_pack_args(IPluginContext *pContext, const cell_t *params) {
 	// Param 1
-	char *sJSON;
-	pContext->LocalToString(params[1], &sJSON);
-
-    json_error_t error;
-    json_t *object = json_loads(sJSON, 0, &error);
+	char *format;
+	pContext->LocalToString(params[1], &format);
+
+	PawnPackArgs args;
+	args.pContext = pContext;
+	args.params = params;
+	args.next = 2;
+	args.sec.pOwner = NULL;
+	args.sec.pIdentity = myself->GetIdentity();
+
+	json_error_t error;
+	json_t *object = json_pack_callback(&error, 0, format, &PackNextArg, &args);
 	if(!object) {
-		g_pSM->LogError(myself, "Error in line %d, col %d: %s", error.line, error.column, error.text);
-		return BAD_HANDLE;
+		return pContext->ThrowNativeError("Could not pack '%s' (position %d): %s", format, error.position, error.text);
+	}
+
+	if(args.next <= params[0]) {
+		json_decref(object);
+		return pContext->ThrowNativeError("Could not pack '%s': %d argument(s) left over", format, params[0] - args.next + 1);
+	}
+
+	for(size_t i = 0; i < args.stolen.size(); i++) {
+		g_pHandleSys->FreeHandle(args.stolen[i], NULL);
 	}
 
 	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
@@ -1291,65 +3106,376 @@ static cell_t Native_json_load(IPluginContext *pContext, const cell_t *params) {
 	return hndlResult;
 }
 
-//native Handle:json_load_ex(const String:sJSON[], String:sErrorText[], maxlen, &iLine, &iColumn);
-static cell_t Native_json_load_ex(IPluginContext *pContext, const cell_t *params) {
+// Drops the references held by the 'O' targets from index first on,
+// for when they won't be handed to the plugin.
+static void ReleaseUnpackTargets(PawnUnpackArgs &args, size_t first) {
+	for(size_t i = first; i < args.targets.size(); i++) {
+		if(args.targets[i].type == 'O' && args.targets[i].value.json) {
+			json_decref(args.targets[i].value.json);
+		}
+	}
+}
+
+//native bool:json_unpack(Handle:hObj, const String:sFormat[], any:...);
+static cell_t Native_json_unpack(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
 	// Param 1
-	char *sJSON;
-	pContext->LocalToString(params[1], &sJSON);
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+        return pContext->ThrowNativeError("Invalid <Object> handle %x (error %d)", hndlObject, err);
+    }
 
-    json_error_t error;
-    json_t *object = json_loads(sJSON, 0, &error);
-	if(!object) {
-		pContext->StringToLocalUTF8(params[2], params[3], error.text, NULL);
+	// Param 2
+	char *format;
+	pContext->LocalToString(params[2], &format);
 
-		cell_t *pLineValue;
-		pContext->LocalToPhysAddr(params[4], &pLineValue);
-		*pLineValue = error.line;
+	PawnUnpackArgs args;
+	args.pContext = pContext;
+	args.params = params;
+	args.next = 3;
 
-		cell_t *pColumnValue;		
-		pContext->LocalToPhysAddr(params[5], &pColumnValue);		
-		*pColumnValue = error.column;
+	json_error_t error;
+	if(json_unpack_callback(object, &error, 0, format, &UnpackNextArg, &args) != 0) {
+		ReleaseUnpackTargets(args, 0);
 
-		return BAD_HANDLE;
-	}
+		// Data that doesn't match is an expected outcome, a broken
+		// format string or argument list is not.
+		if(strcmp(error.source, "<validation>") == 0) {
+			return false;
+		}
 
-	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+		return pContext->ThrowNativeError("Could not unpack '%s' (position %d): %s", format, error.position, error.text);
+	}
 
-	if(hndlResult == BAD_HANDLE) {
-		pContext->ThrowNativeError("Could not create <Object> handle.");
+	for(size_t i = 0; i < args.targets.size(); i++) {
+		PawnUnpackTarget &target = args.targets[i];
+		switch(target.type) {
+			case 's':
+				if(target.value.string) {
+					pContext->StringToLocalUTF8(target.local, target.maxlength, target.value.string, NULL);
+				}
+				break;
+
+			case 'b':
+			case 'i':
+				*target.addr = target.value.integer;
+				break;
+
+			case 'I':
+				*target.addr = (cell_t)target.value.json_int;
+				break;
+
+			case 'f':
+			case 'F':
+				*target.addr = sp_ftoc((float)target.value.real);
+				break;
+
+			case 'O':
+			case 'o':
+				if(target.value.json) {
+					if(target.type == 'o') {
+						json_incref(target.value.json);
+					}
+
+					Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, target.value.json, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+					if(hndlResult == BAD_HANDLE) {
+						json_decref(target.value.json);
+						ReleaseUnpackTargets(args, i + 1);
+						pContext->ThrowNativeError("Could not create <Object> handle.");
+						return false;
+					}
+
+					*target.addr = hndlResult;
+				}
+				break;
+		}
 	}
 
-	return hndlResult;
+	return true;
 }
 
+/**
+ * Asynchronous jobs
+ *
+ * The jobs below do the parsing/serializing/copying and any disk access on
+ * the shared worker pool and report back to the plugin via a private
+ * forward. Using a forward instead of a plain IPluginFunction means the
+ * callback is dropped automatically if the plugin unloads in the meantime.
+ *
+ * Values passed into a job are shared with the worker thread until the
+ * job has completed, so the plugin must not modify them in the meantime.
+ */
+static const ParamType s_LoadCallbackTypes[] = {Param_Cell, Param_String, Param_Cell, Param_Cell, Param_Cell};
+static const ParamType s_DumpCallbackTypes[] = {Param_String, Param_Cell, Param_Cell};
+static const ParamType s_DumpFileCallbackTypes[] = {Param_Cell, Param_Cell};
+static const ParamType s_CopyCallbackTypes[] = {Param_Cell, Param_Cell};
+static const ParamType s_EqualCallbackTypes[] = {Param_Cell, Param_Cell};
+
+class JanssonPluginJob : public JanssonJob
+{
+	public:
+		JanssonPluginJob(IChangeableForward *callback, IdentityToken_t *owner, cell_t data)
+			: m_pCallback(callback), m_pOwner(owner), m_Data(data) {
+		}
 
-//native Handle:json_load_file(const String:sFilePath[PLATFORM_MAX_PATH]);
-static cell_t Native_json_load_file(IPluginContext *pContext, const cell_t *params) {
-	// Param 1
-	char *jsonfile;
-	pContext->LocalToString(params[1], &jsonfile);
+		virtual ~JanssonPluginJob() {
+			forwards->ReleaseForward(m_pCallback);
+		}
 
-	char filePath[PLATFORM_MAX_PATH];
-	g_pSM->BuildPath(Path_Game, filePath, sizeof(filePath), jsonfile);
+	protected:
+		// False if the plugin has been unloaded since the job was queued.
+		bool IsCallbackAlive() {
+			return m_pCallback->GetFunctionCount() > 0;
+		}
 
-    json_error_t error;
-    json_t *object = json_load_file(filePath, 0, &error);
-	if(!object) {
-		g_pSM->LogError(myself, "Error in line %d, col %d: %s", error.line, error.column, error.text);
-		return BAD_HANDLE;
+		// Moves *value into a new handle owned by the plugin. *value is
+		// left untouched if no handle could be created.
+		Handle_t CreateResultHandle(json_t **value) {
+			if(*value == NULL) {
+				return BAD_HANDLE;
+			}
+
+			Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, *value, m_pOwner, myself->GetIdentity(), NULL);
+			if(hndlResult != BAD_HANDLE) {
+				*value = NULL;
+			}
+
+			return hndlResult;
+		}
+
+	protected:
+		IChangeableForward *m_pCallback;
+		IdentityToken_t *m_pOwner;
+		cell_t m_Data;
+};
+
+class JanssonLoadJob : public JanssonPluginJob
+{
+	public:
+		JanssonLoadJob(const char *source, bool bIsFile, IChangeableForward *callback, IdentityToken_t *owner, cell_t data)
+			: JanssonPluginJob(callback, owner, data), m_Source(source), m_bIsFile(bIsFile), m_pResult(NULL) {
+			memset(&m_Error, 0, sizeof(m_Error));
+		}
+
+		~JanssonLoadJob() {
+			if(m_pResult != NULL) {
+				json_decref(m_pResult);
+			}
+		}
+
+		void RunThread() {
+			if(m_bIsFile) {
+				m_pResult = json_load_file(m_Source.c_str(), 0, &m_Error);
+			} else {
+				m_pResult = json_loadb(m_Source.data(), m_Source.size(), 0, &m_Error);
+			}
+		}
+
+		void RunCompletion() {
+			if(!IsCallbackAlive()) {
+				return;
+			}
+
+			Handle_t hndlResult = CreateResultHandle(&m_pResult);
+			if(hndlResult == BAD_HANDLE && m_pResult != NULL) {
+				snprintf(m_Error.text, sizeof(m_Error.text), "Could not create <Object> handle.");
+			}
+
+			m_pCallback->PushCell(hndlResult);
+			m_pCallback->PushString(m_Error.text);
+			m_pCallback->PushCell(m_Error.line);
+			m_pCallback->PushCell(m_Error.column);
+			m_pCallback->PushCell(m_Data);
+			m_pCallback->Execute(NULL);
+		}
+
+	private:
+		std::string m_Source;
+		bool m_bIsFile;
+		json_t *m_pResult;
+		json_error_t m_Error;
+};
+
+class JanssonDumpJob : public JanssonPluginJob
+{
+	public:
+		JanssonDumpJob(json_t *object, size_t flags, IChangeableForward *callback, IdentityToken_t *owner, cell_t data)
+			: JanssonPluginJob(callback, owner, data), m_pObject(json_incref(object)), m_Flags(flags), m_pResult(NULL) {
+		}
+
+		~JanssonDumpJob() {
+			json_decref(m_pObject);
+			free(m_pResult);
+		}
+
+		void RunThread() {
+			m_pResult = json_dumps(m_pObject, m_Flags);
+		}
+
+		void RunCompletion() {
+			if(!IsCallbackAlive()) {
+				return;
+			}
+
+			m_pCallback->PushString(m_pResult != NULL ? m_pResult : "");
+			m_pCallback->PushCell(m_pResult != NULL ? (cell_t)strlen(m_pResult) : -1);
+			m_pCallback->PushCell(m_Data);
+			m_pCallback->Execute(NULL);
+		}
+
+	private:
+		json_t *m_pObject;
+		size_t m_Flags;
+		char *m_pResult;
+};
+
+class JanssonDumpFileJob : public JanssonPluginJob
+{
+	public:
+		JanssonDumpFileJob(json_t *object, const char *path, size_t flags, IChangeableForward *callback, IdentityToken_t *owner, cell_t data)
+			: JanssonPluginJob(callback, owner, data), m_pObject(json_incref(object)), m_Path(path), m_Flags(flags), m_bSuccess(false) {
+			g_WritingFiles.insert(m_Path);
+		}
+
+		~JanssonDumpFileJob() {
+			g_WritingFiles.erase(g_WritingFiles.find(m_Path));
+			json_decref(m_pObject);
+		}
+
+		void RunThread() {
+			m_bSuccess = (json_dump_file(m_pObject, m_Path.c_str(), m_Flags) == 0);
+		}
+
+		void RunCompletion() {
+			if(!IsCallbackAlive()) {
+				return;
+			}
+
+			m_pCallback->PushCell(m_bSuccess);
+			m_pCallback->PushCell(m_Data);
+			m_pCallback->Execute(NULL);
+		}
+
+	private:
+		json_t *m_pObject;
+		std::string m_Path;
+		size_t m_Flags;
+		bool m_bSuccess;
+};
+
+class JanssonDeepCopyJob : public JanssonPluginJob
+{
+	public:
+		JanssonDeepCopyJob(json_t *object, IChangeableForward *callback, IdentityToken_t *owner, cell_t data)
+			: JanssonPluginJob(callback, owner, data), m_pObject(json_incref(object)), m_pResult(NULL) {
+		}
+
+		~JanssonDeepCopyJob() {
+			json_decref(m_pObject);
+			if(m_pResult != NULL) {
+				json_decref(m_pResult);
+			}
+		}
+
+		void RunThread() {
+			m_pResult = json_deep_copy(m_pObject);
+		}
+
+		void RunCompletion() {
+			if(!IsCallbackAlive()) {
+				return;
+			}
+
+			m_pCallback->PushCell(CreateResultHandle(&m_pResult));
+			m_pCallback->PushCell(m_Data);
+			m_pCallback->Execute(NULL);
+		}
+
+	private:
+		json_t *m_pObject;
+		json_t *m_pResult;
+};
+
+class JanssonEqualJob : public JanssonPluginJob
+{
+	public:
+		JanssonEqualJob(json_t *object, json_t *other, IChangeableForward *callback, IdentityToken_t *owner, cell_t data)
+			: JanssonPluginJob(callback, owner, data), m_pObject(json_incref(object)), m_pOther(json_incref(other)), m_bEqual(false) {
+		}
+
+		~JanssonEqualJob() {
+			json_decref(m_pObject);
+			json_decref(m_pOther);
+		}
+
+		void RunThread() {
+			m_bEqual = (json_equal(m_pObject, m_pOther) == 1);
+		}
+
+		void RunCompletion() {
+			if(!IsCallbackAlive()) {
+				return;
+			}
+
+			m_pCallback->PushCell(m_bEqual);
+			m_pCallback->PushCell(m_Data);
+			m_pCallback->Execute(NULL);
+		}
+
+	private:
+		json_t *m_pObject;
+		json_t *m_pOther;
+		bool m_bEqual;
+};
+
+static IChangeableForward *CreateCallbackForward(IPluginContext *pContext, cell_t funcid, const ParamType *types, int numParams) {
+	IPluginFunction *pFunction = pContext->GetFunctionById(funcid);
+	if(pFunction == NULL) {
+		return NULL;
 	}
 
-	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
+	IChangeableForward *pForward = forwards->CreateForwardEx(NULL, ET_Ignore, numParams, types);
+	if(pForward == NULL) {
+		return NULL;
+	}
 
-	if(hndlResult == BAD_HANDLE) {
-		pContext->ThrowNativeError("Could not create <Object> handle.");
+	pForward->AddFunction(pFunction);
+	return pForward;
+}
+
+static cell_t QueueJob(JanssonJob *job) {
+	if(!g_JanssonWorkerPool.AddJob(job)) {
+		delete job;
+		return false;
 	}
 
-	return hndlResult;
+	return true;
 }
 
-//native Handle:json_load_file_ex(const String:sFilePath[PLATFORM_MAX_PATH], String:sErrorText[], maxlen, &iLine, &iColumn);
-static cell_t Native_json_load_file_ex(IPluginContext *pContext, const cell_t *params) {
+//native bool:json_load_async(const String:sJSON[], JsonLoadCallback:callback, any:data = 0);
+static cell_t Native_json_load_async(IPluginContext *pContext, const cell_t *params) {
+	// Param 1
+	char *sJSON;
+	pContext->LocalToString(params[1], &sJSON);
+
+	// Param 2
+	IChangeableForward *pCallback = CreateCallbackForward(pContext, params[2], s_LoadCallbackTypes, 5);
+	if(pCallback == NULL) {
+		return pContext->ThrowNativeError("Invalid callback function %x", params[2]);
+	}
+
+	// Param 3: data
+	return QueueJob(new JanssonLoadJob(sJSON, false, pCallback, pContext->GetIdentity(), params[3]));
+}
+
+//native bool:json_load_file_async(const String:sFilePath[], JsonLoadCallback:callback, any:data = 0);
+static cell_t Native_json_load_file_async(IPluginContext *pContext, const cell_t *params) {
 	// Param 1
 	char *jsonfile;
 	pContext->LocalToString(params[1], &jsonfile);
@@ -1357,33 +3483,18 @@ static cell_t Native_json_load_file_ex(IPluginContext *pContext, const cell_t *p
 	char filePath[PLATFORM_MAX_PATH];
 	g_pSM->BuildPath(Path_Game, filePath, sizeof(filePath), jsonfile);
 
-    json_error_t error;
-    json_t *object = json_load_file(filePath, 0, &error);
-	if(!object) {
-		pContext->StringToLocalUTF8(params[2], params[3], error.text, NULL);
-
-		cell_t *pLineValue;
-		pContext->LocalToPhysAddr(params[4], &pLineValue);
-		*pLineValue = error.line;
-
-		cell_t *pColumnValue;		
-		pContext->LocalToPhysAddr(params[5], &pColumnValue);		
-		*pColumnValue = error.column;
-
-		return BAD_HANDLE;
-	}
-
-	Handle_t hndlResult = g_pHandleSys->CreateHandle(htJanssonObject, object, pContext->GetIdentity(), myself->GetIdentity(), NULL);
-
-	if(hndlResult == BAD_HANDLE) {
-		pContext->ThrowNativeError("Could not create <Object> handle.");
+	// Param 2
+	IChangeableForward *pCallback = CreateCallbackForward(pContext, params[2], s_LoadCallbackTypes, 5);
+	if(pCallback == NULL) {
+		return pContext->ThrowNativeError("Invalid callback function %x", params[2]);
 	}
 
-	return hndlResult;
+	// Param 3: data
+	return QueueJob(new JanssonLoadJob(filePath, true, pCallback, pContext->GetIdentity(), params[3]));
 }
 
-//native json_dump(Handle:hObject, String:sJSON[], maxlength, iIndentWidth = 4, bool:bEnsureAscii = false, bool:bSortKeys = false, bool:bPreserveOrder = false);
-static cell_t Native_json_dump(IPluginContext *pContext, const cell_t *params) {
+//native bool:json_dump_async(Handle:hObject, JsonDumpStringCallback:callback, any:data = 0, iIndentWidth = 4, bool:bEnsureAscii = false, bool:bSortKeys = false, bool:bPreserveOrder = false);
+static cell_t Native_json_dump_async(IPluginContext *pContext, const cell_t *params) {
 	HandleError err;
 	HandleSecurity sec;
 	sec.pOwner = NULL;
@@ -1410,20 +3521,18 @@ static cell_t Native_json_dump(IPluginContext *pContext, const cell_t *params) {
 		flags = flags | JSON_PRESERVE_ORDER;
 	}
 
-	// Return
-	char *result = json_dumps(object, flags);
-	if(result != NULL) {
-		pContext->StringToLocalUTF8(params[2], params[3], result, NULL);
-		size_t length = strlen(result);
-		free(result);
-		return length;
+	// Param 2
+	IChangeableForward *pCallback = CreateCallbackForward(pContext, params[2], s_DumpCallbackTypes, 3);
+	if(pCallback == NULL) {
+		return pContext->ThrowNativeError("Invalid callback function %x", params[2]);
 	}
 
-	return -1;
+	// Param 3: data
+	return QueueJob(new JanssonDumpJob(object, flags, pCallback, pContext->GetIdentity(), params[3]));
 }
 
-//native bool:json_dump_file(Handle:hObject, const String:sFilePath[], iIndentWidth = 4, bool:bEnsureAscii = false, bool:bSortKeys = false, bool:bPreserveOrder = false);
-static cell_t Native_json_dump_file(IPluginContext *pContext, const cell_t *params) {
+//native bool:json_dump_file_async(Handle:hObject, const String:sFilePath[], JsonDumpCallback:callback, any:data = 0, iIndentWidth = 4, bool:bEnsureAscii = false, bool:bSortKeys = false, bool:bPreserveOrder = false);
+static cell_t Native_json_dump_file_async(IPluginContext *pContext, const cell_t *params) {
 	HandleError err;
 	HandleSecurity sec;
 	sec.pOwner = NULL;
@@ -1440,29 +3549,95 @@ static cell_t Native_json_dump_file(IPluginContext *pContext, const cell_t *para
 	// Param 2
 	char *jsonfile;
 	pContext->LocalToString(params[2], &jsonfile);
-	
+
 	char filePath[PLATFORM_MAX_PATH];
 	g_pSM->BuildPath(Path_Game, filePath, sizeof(filePath), jsonfile);
 
-
-	size_t flags = JSON_INDENT(params[3]);		// Param 3: iIndentWidth
-	if(params[4] == 1) {						// Param 4: bEnsureAscii
+	size_t flags = JSON_INDENT(params[5]);		// Param 5: iIndentWidth
+	if(params[6] == 1) {						// Param 6: bEnsureAscii
 		flags = flags | JSON_ENSURE_ASCII;
 	}
 
-	if(params[5] == 1) {						// Param 5: bSortKeys
+	if(params[7] == 1) {						// Param 7: bSortKeys
 		flags = flags | JSON_SORT_KEYS;
 	}
 
-	if(params[6] == 1) {						// Param 6: bPreserveOrder
+	if(params[8] == 1) {						// Param 8: bPreserveOrder
 		flags = flags | JSON_PRESERVE_ORDER;
 	}
 
-	// Return
-	bool bSuccess = (json_dump_file(object, filePath, flags) == 0);
-	return bSuccess;
+	// Param 3
+	IChangeableForward *pCallback = CreateCallbackForward(pContext, params[3], s_DumpFileCallbackTypes, 2);
+	if(pCallback == NULL) {
+		return pContext->ThrowNativeError("Invalid callback function %x", params[3]);
+	}
+
+	// Param 4: data
+	return QueueJob(new JanssonDumpFileJob(object, filePath, flags, pCallback, pContext->GetIdentity(), params[4]));
+}
+
+//native bool:json_deep_copy_async(Handle:hObj, JsonCopyCallback:callback, any:data = 0);
+static cell_t Native_json_deep_copy_async(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1: hObj
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+		return pContext->ThrowNativeError("Invalid <JSON Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	// Param 2
+	IChangeableForward *pCallback = CreateCallbackForward(pContext, params[2], s_CopyCallbackTypes, 2);
+	if(pCallback == NULL) {
+		return pContext->ThrowNativeError("Invalid callback function %x", params[2]);
+	}
+
+	// Param 3: data
+	return QueueJob(new JanssonDeepCopyJob(object, pCallback, pContext->GetIdentity(), params[3]));
+}
+
+//native bool:json_equal_async(Handle:hObj, Handle:hOther, JsonEqualCallback:callback, any:data = 0);
+static cell_t Native_json_equal_async(IPluginContext *pContext, const cell_t *params) {
+	HandleError err;
+	HandleSecurity sec;
+	sec.pOwner = NULL;
+	sec.pIdentity = myself->GetIdentity();
+
+	// Param 1: hObj
+	json_t *object;
+	Handle_t hndlObject = static_cast<Handle_t>(params[1]);
+	if ((err=g_pHandleSys->ReadHandle(hndlObject, htJanssonObject, &sec, (void **)&object)) != HandleError_None)
+    {
+		return pContext->ThrowNativeError("Invalid <JSON Object> handle %x (error %d)", hndlObject, err);
+    }
+
+	// Param 2: hOther
+	json_t *other;
+	Handle_t hndlOther = static_cast<Handle_t>(params[2]);
+	if ((err=g_pHandleSys->ReadHandle(hndlOther, htJanssonObject, &sec, (void **)&other)) != HandleError_None)
+    {
+		return pContext->ThrowNativeError("Invalid <JSON Object> handle %x (error %d)", hndlOther, err);
+    }
+
+	// Param 3
+	IChangeableForward *pCallback = CreateCallbackForward(pContext, params[3], s_EqualCallbackTypes, 2);
+	if(pCallback == NULL) {
+		return pContext->ThrowNativeError("Invalid callback function %x", params[3]);
+	}
+
+	// Param 4: data
+	return QueueJob(new JanssonEqualJob(object, other, pCallback, pContext->GetIdentity(), params[4]));
 }
 
+//native json_async_pending();
+static cell_t Native_json_async_pending(IPluginContext *pContext, const cell_t *params) {
+	return g_JanssonWorkerPool.GetJobCount();
+}
 
 const sp_nativeinfo_t json_natives[] =
 {
@@ -1473,6 +3648,11 @@ const sp_nativeinfo_t json_natives[] =
 	{"json_object_set",							Native_json_object_set},
 	{"json_object_set_new",						Native_json_object_set_new},
 	{"json_object_del",							Native_json_object_del},
+	{"json_key_prepare",						Native_json_key_prepare},
+	{"json_object_get_key",						Native_json_object_get_key},
+	{"json_object_set_key",						Native_json_object_set_key},
+	{"json_object_set_new_key",					Native_json_object_set_new_key},
+	{"json_object_del_key",						Native_json_object_del_key},
 	{"json_object_clear",						Native_json_object_clear},
 	{"json_object_update",						Native_json_object_update},
 	{"json_object_update_existing",				Native_json_object_update_existing},
@@ -1486,7 +3666,16 @@ const sp_nativeinfo_t json_natives[] =
 	{"json_object_iter_value",					Native_json_object_iter_value},
 	{"json_object_iter_set",					Native_json_object_iter_set},
 	{"json_object_iter_set_new",				Native_json_object_iter_set_new},
-	//{"json_object_foreach",						Native_json_object_foreach},
+
+	// Cursors
+	{"json_cursor",								Native_json_cursor},
+	{"json_cursor_next",						Native_json_cursor_next},
+	{"json_cursor_reset",						Native_json_cursor_reset},
+	{"json_cursor_value",						Native_json_cursor_value},
+	{"json_cursor_get_int",						Native_json_cursor_get_int},
+	{"json_cursor_get_float",					Native_json_cursor_get_float},
+	{"json_cursor_get_bool",					Native_json_cursor_get_bool},
+	{"json_cursor_get_string",					Native_json_cursor_get_string},
 
 	// Arrays
 	{"json_array",								Native_json_array},
@@ -1500,6 +3689,16 @@ const sp_nativeinfo_t json_natives[] =
 	{"json_array_remove",						Native_json_array_remove},
 	{"json_array_clear",						Native_json_array_clear},
 	{"json_array_extend",						Native_json_array_extend},
+	{"json_array_get_ints",						Native_json_array_get_ints},
+	{"json_array_get_floats",					Native_json_array_get_floats},
+	{"json_array_get_bools",					Native_json_array_get_bools},
+	{"json_array_get_strings",					Native_json_array_get_strings},
+	{"json_array_from_ints",					Native_json_array_from_ints},
+	{"json_array_from_floats",					Native_json_array_from_floats},
+	{"json_array_from_strings",					Native_json_array_from_strings},
+	{"json_array_append_ints",					Native_json_array_append_ints},
+	{"json_array_append_floats",				Native_json_array_append_floats},
+	{"json_array_append_strings",				Native_json_array_append_strings},
 	{"json_array_size",							Native_json_array_size},
 
 	// Type
@@ -1507,10 +3706,12 @@ const sp_nativeinfo_t json_natives[] =
 
 	// Equality
 	{"json_equal",								Native_json_equal},
+	{"json_equal_async",						Native_json_equal_async},
 
 	// Copying
 	{"json_copy",								Native_json_copy},
 	{"json_deep_copy",							Native_json_deep_copy},
+	{"json_deep_copy_async",					Native_json_deep_copy_async},
 
 	// Values
 	{"json_boolean",							Native_json_boolean},
@@ -1525,24 +3726,67 @@ const sp_nativeinfo_t json_natives[] =
 	{"json_integer",							Native_json_integer},
 	{"json_integer_value",						Native_json_integer_value},
 	{"json_integer_set",						Native_json_integer_set},
+	{"json_integer64",							Native_json_integer64},
+	{"json_integer64_value",					Native_json_integer64_value},
+	{"json_integer64_set",						Native_json_integer64_set},
+	{"json_integer_from_string",				Native_json_integer_from_string},
+	{"json_integer_to_string",					Native_json_integer_to_string},
+	{"json_steamid",							Native_json_steamid},
+	{"json_steamid_account",					Native_json_steamid_account},
 
 	{"json_real",								Native_json_real},
 	{"json_real_value",							Native_json_real_value},
 	{"json_real_set",							Native_json_real_set},
 	{"json_number_value",						Native_json_number_value},
 
+	// JSON Pointer
+	{"json_path_get",							Native_json_path_get},
+	{"json_path_get_int",						Native_json_path_get_int},
+	{"json_path_get_float",						Native_json_path_get_float},
+	{"json_path_get_bool",						Native_json_path_get_bool},
+	{"json_path_get_string",					Native_json_path_get_string},
+	{"json_path_set_int",						Native_json_path_set_int},
+	{"json_path_set_float",						Native_json_path_set_float},
+	{"json_path_set_bool",						Native_json_path_set_bool},
+	{"json_path_set_string",					Native_json_path_set_string},
+	{"json_path_set_value",						Native_json_path_set_value},
+
+	// Views
+	{"json_view",								Native_json_view},
+	{"json_view_reset",							Native_json_view_reset},
+	{"json_view_object_get",					Native_json_view_object_get},
+	{"json_view_object_get_key",				Native_json_view_object_get_key},
+	{"json_view_array_get",						Native_json_view_array_get},
+	{"json_view_path_get",						Native_json_view_path_get},
+	{"json_view_typeof",						Native_json_view_typeof},
+	{"json_view_size",							Native_json_view_size},
+	{"json_view_get_int",						Native_json_view_get_int},
+	{"json_view_get_float",						Native_json_view_get_float},
+	{"json_view_get_bool",						Native_json_view_get_bool},
+	{"json_view_get_string",					Native_json_view_get_string},
+	{"json_view_get",							Native_json_view_get},
+
 	// Encoding
 	{"json_dump",								Native_json_dump},
+	{"json_dump_async",							Native_json_dump_async},
 	{"json_dump_file",							Native_json_dump_file},
+	{"json_dump_file_async",					Native_json_dump_file_async},
+	{"json_dump_size",							Native_json_dump_size},
 
 	// Decoding
 	{"json_load",								Native_json_load},
 	{"json_load_ex",							Native_json_load_ex},
+	{"json_load_async",							Native_json_load_async},
 	{"json_load_file",							Native_json_load_file},
 	{"json_load_file_ex",						Native_json_load_file_ex},
+	{"json_load_file_async",					Native_json_load_file_async},
+
+	// Worker pool
+	{"json_async_pending",						Native_json_async_pending},
 
 	// Building objects & arrays
-	//{"json_unpack",							Native_json_unpack},
+	{"json_pack_args",							Native_json_pack_args},
+	{"json_unpack",							Native_json_unpack},
 
 	{NULL,				NULL}
 };
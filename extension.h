@@ -38,6 +38,10 @@
  */
 
 #include "smsdk_ext.h"
+#include "jansson/src/jansson.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 
 /**
@@ -60,7 +64,7 @@ public:
 	/**
 	 * @brief This is called right before the extension is unloaded.
 	 */
-	//virtual void SDK_OnUnload();
+	virtual void SDK_OnUnload();
 
 	/**
 	 * @brief This is called once all known extensions have been loaded.
@@ -132,6 +136,147 @@ class JanssonIteratorHandler : public IHandleTypeDispatch
 
 extern JanssonIteratorHandler g_JanssonIteratorHandler;
 
+/**
+ * @brief A read-only window into a JSON tree.
+ *
+ * Values looked up through a view are kept in a node table and handed to
+ * the plugin as plain cells instead of handles. A node reference holds the
+ * table index in the low JANSSON_VIEW_INDEX_BITS and the generation of the
+ * view above that. Reset() drops all nodes but the root and bumps the
+ * generation, so older references are rejected instead of pointing at
+ * whatever reuses their slot.
+ */
+#define JANSSON_VIEW_INDEX_BITS		20
+#define JANSSON_VIEW_MAX_NODES		(1 << JANSSON_VIEW_INDEX_BITS)
+#define JANSSON_VIEW_MAX_GENERATION	0x7FF
+
+class JanssonView
+{
+	public:
+		JanssonView(json_t *root);
+		~JanssonView();
+
+		/**
+		 * @brief Returns the value behind a node reference, or NULL if the
+		 * reference is invalid or stale. Reference 0 is always the root.
+		 */
+		json_t *Resolve(cell_t node);
+
+		/**
+		 * @brief Adds a value to the node table.
+		 *
+		 * @return			Node reference, or -1 if the table is full.
+		 */
+		cell_t Add(json_t *value);
+
+		void Reset();
+
+	private:
+		std::vector<json_t *> m_Nodes;
+		unsigned int m_Generation;
+};
+
+class JanssonViewHandler : public IHandleTypeDispatch
+{
+	public:
+		void OnHandleDestroy(HandleType_t type, void *object);
+};
+
+extern JanssonViewHandler g_JanssonViewHandler;
+
+/**
+ * @brief Walks the keys of an object in place.
+ *
+ * Unlike object iterators, a cursor is a single handle that moves forward
+ * without being replaced. It keeps a reference to the object and always
+ * looks one pair ahead. Pairs may be freed when keys are removed, so once
+ * the object's revision changes the cursor finds its place again by the
+ * current and next key instead of trusting the iterators it held.
+ */
+class JanssonCursor
+{
+	public:
+		JanssonCursor(json_t *object);
+		~JanssonCursor();
+
+		/**
+		 * @brief Moves to the next pair.
+		 *
+		 * @return			False if there are no pairs left.
+		 */
+		bool Next();
+
+		/**
+		 * @brief Moves back to before the first pair.
+		 */
+		void Reset();
+
+		/**
+		 * @brief Returns the key or value of the current pair, or NULL if
+		 * Next() was not called yet, returned false, or the current key
+		 * has been removed from the object since.
+		 */
+		const char *GetKey();
+		json_t *GetValue();
+
+	private:
+		// Looks the pairs up again if keys were added or removed.
+		void Refresh();
+
+	private:
+		json_t *m_Object;
+		void *m_Iter;
+		void *m_Next;
+		std::string m_Key;
+		std::string m_NextKey;
+		size_t m_Revision;
+		bool m_bStarted;
+};
+
+class JanssonCursorHandler : public IHandleTypeDispatch
+{
+	public:
+		void OnHandleDestroy(HandleType_t type, void *object);
+};
+
+extern JanssonCursorHandler g_JanssonCursorHandler;
+
+/**
+ * @brief Object keys prepared by json_key_prepare().
+ *
+ * Keys are shared by all plugins and kept until the extension unloads, so
+ * preparing the same string again returns the same token. A token is the
+ * table index plus one, leaving 0 for variables that were never prepared.
+ */
+#define JANSSON_MAX_KEYS			65536
+
+class JanssonKeyTable
+{
+	public:
+		~JanssonKeyTable();
+
+		/**
+		 * @brief Returns the token for a key, adding it if needed.
+		 *
+		 * @return			Token, or 0 if the key is not valid UTF-8 or
+		 *					the table is full.
+		 */
+		cell_t Prepare(const char *key);
+
+		/**
+		 * @brief Returns the key behind a token, or NULL if there is none.
+		 */
+		json_key_t *Resolve(cell_t token);
+
+		void Clear();
+
+	private:
+		std::vector<json_key_t *> m_Keys;
+		std::unordered_map<std::string, cell_t> m_Tokens;
+};
+
+extern JanssonKeyTable g_JanssonKeys;
+
 extern const sp_nativeinfo_t json_natives[];
 
 #endif // _INCLUDE_SOURCEMOD_EXTENSION_PROPER_H_
@@ -23,7 +23,6 @@
 #define MAX_REAL_STR_LENGTH     100
 
 struct object_key {
-    size_t serial;
     const char *key;
 };
 
@@ -67,21 +66,34 @@ static int dump_indent(size_t flags, int depth, int space, json_dump_callback_t
 
 static int dump_string(const char *str, json_dump_callback_t dump, void *data, size_t flags)
 {
-    const char *pos, *end;
+    const char *pos, *end, *limit;
     int32_t codepoint;
 
     if(dump("\"", 1, data))
         return -1;
 
     end = pos = str;
+    limit = str + strlen(str);
     while(1)
     {
         const char *text;
         char seq[13];
         int length;
 
-        while(*end)
+        while(pos != limit)
         {
+            /* skip over characters that never need escaping in bulk */
+            size_t plain = utf8_plain_length(pos, limit - pos);
+            if(flags & JSON_ESCAPE_SLASH) {
+                const char *slash = memchr(pos, '/', plain);
+                if(slash)
+                    plain = slash - pos;
+            }
+
+            pos += plain;
+            if(pos == limit)
+                break;
+
             end = utf8_iterate(pos, &codepoint);
             if(!end)
                 return -1;
@@ -106,7 +118,7 @@ static int dump_string(const char *str, json_dump_callback_t dump, void *data, s
                 return -1;
         }
 
-        if(end == pos)
+        if(pos == limit)
             break;
 
         /* handle \, /, ", and control codes */
@@ -163,15 +175,29 @@ static int object_key_compare_keys(const void *key1, const void *key2)
                   ((const struct object_key *)key2)->key);
 }
 
-static int object_key_compare_serials(const void *key1, const void *key2)
+/* The containers on the way from the root down to the value that is
+   being encoded. Circular references are detected by looking through
+   this chain rather than by marking the values, so that several threads
+   can encode the same tree at once. */
+struct dump_parent {
+    const json_t *json;
+    const struct dump_parent *up;
+};
+
+static int dump_is_parent(const struct dump_parent *parent, const json_t *json)
 {
-    size_t a = ((const struct object_key *)key1)->serial;
-    size_t b = ((const struct object_key *)key2)->serial;
+    while(parent)
+    {
+        if(parent->json == json)
+            return 1;
+        parent = parent->up;
+    }
 
-    return a < b ? -1 : a == b ? 0 : 1;
+    return 0;
 }
 
 static int do_dump(const json_t *json, size_t flags, int depth,
+                   const struct dump_parent *parent,
                    json_dump_callback_t dump, void *data)
 {
     if(!json)
@@ -192,10 +218,9 @@ static int do_dump(const json_t *json, size_t flags, int depth,
             char buffer[MAX_INTEGER_STR_LENGTH];
             int size;
 
-            size = snprintf(buffer, MAX_INTEGER_STR_LENGTH,
-                            "%" JSON_INTEGER_FORMAT,
-                            json_integer_value(json));
-            if(size < 0 || size >= MAX_INTEGER_STR_LENGTH)
+            size = jsonp_itostr(buffer, MAX_INTEGER_STR_LENGTH,
+                                json_integer_value(json));
+            if(size < 0)
                 return -1;
 
             return dump(buffer, size, data);
@@ -221,28 +246,26 @@ static int do_dump(const json_t *json, size_t flags, int depth,
         {
             int i;
             int n;
-            json_array_t *array;
+            struct dump_parent self;
 
             /* detect circular references */
-            array = json_to_array(json);
-            if(array->visited)
-                goto array_error;
-            array->visited = 1;
+            if(dump_is_parent(parent, json))
+                return -1;
+            self.json = json;
+            self.up = parent;
 
             n = json_array_size(json);
 
             if(dump("[", 1, data))
                 goto array_error;
-            if(n == 0) {
-                array->visited = 0;
+            if(n == 0)
                 return dump("]", 1, data);
-            }
             if(dump_indent(flags, depth + 1, 0, dump, data))
                 goto array_error;
 
             for(i = 0; i < n; ++i) {
                 if(do_dump(json_array_get(json, i), flags, depth + 1,
-                           dump, data))
+                           &self, dump, data))
                     goto array_error;
 
                 if(i < n - 1)
@@ -258,17 +281,15 @@ static int do_dump(const json_t *json, size_t flags, int depth,
                 }
             }
 
-            array->visited = 0;
             return dump("]", 1, data);
 
         array_error:
-            array->visited = 0;
             return -1;
         }
 
         case JSON_OBJECT:
         {
-            json_object_t *object;
+            struct dump_parent self;
             void *iter;
             const char *separator;
             int separator_length;
@@ -283,27 +304,26 @@ static int do_dump(const json_t *json, size_t flags, int depth,
             }
 
             /* detect circular references */
-            object = json_to_object(json);
-            if(object->visited)
-                goto object_error;
-            object->visited = 1;
+            if(dump_is_parent(parent, json))
+                return -1;
+            self.json = json;
+            self.up = parent;
 
             iter = json_object_iter((json_t *)json);
 
             if(dump("{", 1, data))
                 goto object_error;
-            if(!iter) {
-                object->visited = 0;
+            if(!iter)
                 return dump("}", 1, data);
-            }
             if(dump_indent(flags, depth + 1, 0, dump, data))
                 goto object_error;
 
-            if(flags & JSON_SORT_KEYS || flags & JSON_PRESERVE_ORDER)
+            /* Objects are iterated in insertion order, so there's
+               nothing to do for JSON_PRESERVE_ORDER */
+            if(flags & JSON_SORT_KEYS)
             {
                 struct object_key *keys;
                 size_t size, i;
-                int (*cmp_func)(const void *, const void *);
 
                 size = json_object_size(json);
                 keys = jsonp_malloc(size * sizeof(struct object_key));
@@ -313,19 +333,14 @@ static int do_dump(const json_t *json, size_t flags, int depth,
                 i = 0;
                 while(iter)
                 {
-                    keys[i].serial = hashtable_iter_serial(iter);
                     keys[i].key = json_object_iter_key(iter);
                     iter = json_object_iter_next((json_t *)json, iter);
                     i++;
                 }
                 assert(i == size);
 
-                if(flags & JSON_SORT_KEYS)
-                    cmp_func = object_key_compare_keys;
-                else
-                    cmp_func = object_key_compare_serials;
-
-                qsort(keys, size, sizeof(struct object_key), cmp_func);
+                qsort(keys, size, sizeof(struct object_key),
+                      object_key_compare_keys);
 
                 for(i = 0; i < size; i++)
                 {
@@ -338,7 +353,7 @@ static int do_dump(const json_t *json, size_t flags, int depth,
 
                     dump_string(key, dump, data, flags);
                     if(dump(separator, separator_length, data) ||
-                       do_dump(value, flags, depth + 1, dump, data))
+                       do_dump(value, flags, depth + 1, &self, dump, data))
                     {
                         jsonp_free(keys);
                         goto object_error;
@@ -376,7 +391,7 @@ static int do_dump(const json_t *json, size_t flags, int depth,
                     dump_string(json_object_iter_key(iter), dump, data, flags);
                     if(dump(separator, separator_length, data) ||
                        do_dump(json_object_iter_value(iter), flags, depth + 1,
-                               dump, data))
+                               &self, dump, data))
                         goto object_error;
 
                     if(next)
@@ -395,11 +410,9 @@ static int do_dump(const json_t *json, size_t flags, int depth,
                 }
             }
 
-            object->visited = 0;
             return dump("}", 1, data);
 
         object_error:
-            object->visited = 0;
             return -1;
         }
 
@@ -409,6 +422,222 @@ static int do_dump(const json_t *json, size_t flags, int depth,
     }
 }
 
+/* Size-only counterparts of the functions above. They walk the tree in
+   exactly the same way as do_dump() but only add up the number of bytes
+   that would have been written. */
+
+static size_t size_indent(size_t flags, int depth, int space)
+{
+    if(JSON_INDENT(flags) > 0)
+        return 1 + (size_t)depth * JSON_INDENT(flags);
+    else if(space && !(flags & JSON_COMPACT))
+        return 1;
+    return 0;
+}
+
+static int size_string(const char *str, size_t flags, size_t *size)
+{
+    const char *pos = str;
+    const char *limit = str + strlen(str);
+    size_t length = 2;
+    int32_t codepoint;
+
+    while(pos != limit)
+    {
+        const char *end;
+        unsigned char c;
+        size_t plain = utf8_plain_length(pos, limit - pos);
+
+        length += plain;
+        if(flags & JSON_ESCAPE_SLASH) {
+            const char *slash = pos;
+            while((slash = memchr(slash, '/', pos + plain - slash)) != NULL) {
+                length++;
+                slash++;
+            }
+        }
+
+        pos += plain;
+        if(pos == limit)
+            break;
+
+        c = (unsigned char)*pos;
+
+        /* plain ASCII, no need to decode */
+        if(c < 0x80)
+        {
+            if(c == '\\' || c == '"' || c == '\b' || c == '\f' ||
+               c == '\n' || c == '\r' || c == '\t' ||
+               (c == '/' && (flags & JSON_ESCAPE_SLASH)))
+                length += 2;
+            else if(c < 0x20)
+                length += 6;
+            else
+                length += 1;
+
+            pos++;
+            continue;
+        }
+
+        end = utf8_iterate(pos, &codepoint);
+        if(!end)
+            return -1;
+
+        if(flags & JSON_ENSURE_ASCII)
+            length += codepoint < 0x10000 ? 6 : 12;
+        else
+            length += end - pos;
+
+        pos = end;
+    }
+
+    *size += length;
+    return 0;
+}
+
+static size_t size_integer(json_int_t value)
+{
+    size_t length = 1;
+    unsigned long long magnitude;
+
+    if(value < 0)
+    {
+        magnitude = 0ULL - (unsigned long long)value;
+        length++;
+    }
+    else
+        magnitude = (unsigned long long)value;
+
+    while(magnitude >= 10)
+    {
+        magnitude /= 10;
+        length++;
+    }
+
+    return length;
+}
+
+static int do_size(const json_t *json, size_t flags, int depth,
+                   const struct dump_parent *parent, size_t *size)
+{
+    if(!json)
+        return -1;
+
+    switch(json_typeof(json)) {
+        case JSON_NULL:
+        case JSON_TRUE:
+            *size += 4;
+            return 0;
+
+        case JSON_FALSE:
+            *size += 5;
+            return 0;
+
+        case JSON_INTEGER:
+            *size += size_integer(json_integer_value(json));
+            return 0;
+
+        case JSON_REAL:
+        {
+            char buffer[MAX_REAL_STR_LENGTH];
+            int length;
+
+            length = jsonp_dtostr(buffer, MAX_REAL_STR_LENGTH,
+                                  json_real_value(json));
+            if(length < 0)
+                return -1;
+
+            *size += length;
+            return 0;
+        }
+
+        case JSON_STRING:
+            return size_string(json_string_value(json), flags, size);
+
+        case JSON_ARRAY:
+        {
+            size_t i, n;
+            struct dump_parent self;
+
+            /* detect circular references */
+            if(dump_is_parent(parent, json))
+                return -1;
+
+            n = json_array_size(json);
+
+            *size += 2;
+            if(n == 0)
+                return 0;
+
+            self.json = json;
+            self.up = parent;
+            *size += size_indent(flags, depth + 1, 0);
+
+            for(i = 0; i < n; ++i) {
+                if(do_size(json_array_get(json, i), flags, depth + 1,
+                           &self, size))
+                    return -1;
+
+                if(i < n - 1)
+                    *size += 1 + size_indent(flags, depth + 1, 1);
+                else
+                    *size += size_indent(flags, depth, 0);
+            }
+
+            return 0;
+        }
+
+        case JSON_OBJECT:
+        {
+            struct dump_parent self;
+            void *iter;
+            size_t separator_length;
+
+            /* detect circular references */
+            if(dump_is_parent(parent, json))
+                return -1;
+
+            iter = json_object_iter((json_t *)json);
+
+            *size += 2;
+            if(!iter)
+                return 0;
+
+            /* Key order does not change the length, so JSON_SORT_KEYS and
+               JSON_PRESERVE_ORDER can be ignored here */
+            separator_length = (flags & JSON_COMPACT) ? 1 : 2;
+
+            self.json = json;
+            self.up = parent;
+            *size += size_indent(flags, depth + 1, 0);
+
+            while(iter)
+            {
+                void *next = json_object_iter_next((json_t *)json, iter);
+
+                if(size_string(json_object_iter_key(iter), flags, size) ||
+                   do_size(json_object_iter_value(iter), flags, depth + 1,
+                           &self, size))
+                    return -1;
+                *size += separator_length;
+
+                if(next)
+                    *size += 1 + size_indent(flags, depth + 1, 1);
+                else
+                    *size += size_indent(flags, depth, 0);
+
+                iter = next;
+            }
+
+            return 0;
+        }
+
+        default:
+            /* not reached */
+            return -1;
+    }
+}
+
 char *json_dumps(const json_t *json, size_t flags)
 {
     strbuffer_t strbuff;
@@ -452,5 +681,20 @@ int json_dump_callback(const json_t *json, json_dump_callback_t callback, void *
            return -1;
     }
 
-    return do_dump(json, flags, 0, callback, data);
+    return do_dump(json, flags, 0, NULL, callback, data);
+}
+
+size_t json_dump_size(const json_t *json, size_t flags)
+{
+    size_t size = 0;
+
+    if(!(flags & JSON_ENCODE_ANY)) {
+        if(!json_is_array(json) && !json_is_object(json))
+           return 0;
+    }
+
+    if(do_size(json, flags, 0, NULL, &size))
+        return 0;
+
+    return size;
 }
@@ -22,7 +22,7 @@
 
 typedef struct hashtable_list list_t;
 typedef struct hashtable_pair pair_t;
-typedef struct hashtable_bucket bucket_t;
+typedef struct hashtable_slot slot_t;
 
 extern volatile uint32_t hashtable_seed;
 
@@ -30,7 +30,19 @@ extern volatile uint32_t hashtable_seed;
 #include "lookup3.h"
 
 #define list_to_pair(list_)  container_of(list_, pair_t, list)
-#define hash_str(key)        ((size_t)hashlittle((key), strlen(key), hashtable_seed))
+#define hash_str(key, len)   ((size_t)hashlittle((key), (len), hashtable_seed))
+
+/* offsetof(...) returns the size of pair_t without the last, flexible
+   member. This way, the correct amount is allocated. */
+#define pair_size(len_)      (offsetof(pair_t, key) + (len_) + 1)
+
+/* Small tables have no slots and are searched linearly, without
+   hashing the key */
+#define HASHTABLE_SMALL_SIZE  8
+
+/* grow when more than half of the slots are used */
+#define hashtable_full(hashtable_) \
+    (((hashtable_)->size + 1) * 2 > hashsize((hashtable_)->order))
 
 static JSON_INLINE void list_init(list_t *list)
 {
@@ -52,80 +64,124 @@ static JSON_INLINE void list_remove(list_t *list)
     list->next->prev = list->prev;
 }
 
-static JSON_INLINE int bucket_is_empty(hashtable_t *hashtable, bucket_t *bucket)
+static pair_t *hashtable_find_small(hashtable_t *hashtable,
+                                   const char *key, size_t len)
 {
-    return bucket->first == &hashtable->list && bucket->first == bucket->last;
-}
+    list_t *list;
+    pair_t *pair;
 
-static void insert_to_bucket(hashtable_t *hashtable, bucket_t *bucket,
-                             list_t *list)
-{
-    if(bucket_is_empty(hashtable, bucket))
+    /* Keys often share a prefix, so look at the length and the last
+       character before comparing the whole key */
+    for(list = hashtable->list.next; list != &hashtable->list; list = list->next)
     {
-        list_insert(&hashtable->list, list);
-        bucket->first = bucket->last = list;
+        pair = list_to_pair(list);
+        if(pair->len == len &&
+           (len == 0 || pair->key[len - 1] == key[len - 1]) &&
+           memcmp(pair->key, key, len) == 0)
+            return pair;
     }
-    else
+
+    return NULL;
+}
+
+/* Returns the slot of key, or the empty slot where it would go */
+static slot_t *hashtable_find_slot(hashtable_t *hashtable,
+                                   const char *key, size_t len, size_t hash)
+{
+    size_t mask = hashmask(hashtable->order);
+    size_t index = hash & mask;
+    slot_t *slot;
+
+    while(1)
     {
-        list_insert(bucket->first, list);
-        bucket->first = list;
+        slot = &hashtable->slots[index];
+        if(!slot->pair)
+            return slot;
+
+        if(slot->hash == hash && slot->pair->len == len &&
+           memcmp(slot->pair->key, key, len) == 0)
+            return slot;
+
+        index = (index + 1) & mask;
     }
 }
 
-static pair_t *hashtable_find_pair(hashtable_t *hashtable, bucket_t *bucket,
-                                   const char *key, size_t hash)
+/* Shift the following slots of the probe sequence back into the one
+   that was freed, so that lookups never need tombstones */
+static void hashtable_remove_slot(hashtable_t *hashtable, slot_t *slot)
 {
-    list_t *list;
-    pair_t *pair;
-
-    if(bucket_is_empty(hashtable, bucket))
-        return NULL;
+    size_t mask = hashmask(hashtable->order);
+    size_t hole = slot - hashtable->slots;
+    size_t index = hole;
+    size_t home;
 
-    list = bucket->first;
     while(1)
     {
-        pair = list_to_pair(list);
-        if(pair->hash == hash && strcmp(pair->key, key) == 0)
-            return pair;
-
-        if(list == bucket->last)
+        index = (index + 1) & mask;
+        slot = &hashtable->slots[index];
+        if(!slot->pair)
             break;
 
-        list = list->next;
+        /* the slot can move if the hole lies between its home and
+           its current position */
+        home = slot->hash & mask;
+        if(((index - home) & mask) >= ((index - hole) & mask))
+        {
+            hashtable->slots[hole] = *slot;
+            hole = index;
+        }
     }
 
-    return NULL;
+    hashtable->slots[hole].pair = NULL;
 }
 
-/* returns 0 on success, -1 if key was not found */
-static int hashtable_do_del(hashtable_t *hashtable,
-                            const char *key, size_t hash)
+/* The small table path is taken before hashing, so callers that
+   already know the hash pass hashed = 1 and the others have it
+   computed only if the table needs it */
+static pair_t *hashtable_find_pair(hashtable_t *hashtable, const char *key,
+                                   size_t len, size_t hash, int hashed)
 {
-    pair_t *pair;
-    bucket_t *bucket;
-    size_t index;
+    if(!hashtable->slots)
+        return hashtable_find_small(hashtable, key, len);
 
-    index = hash & hashmask(hashtable->order);
-    bucket = &hashtable->buckets[index];
+    if(!hashed)
+        hash = hash_str(key, len);
 
-    pair = hashtable_find_pair(hashtable, bucket, key, hash);
-    if(!pair)
-        return -1;
+    return hashtable_find_slot(hashtable, key, len, hash)->pair;
+}
 
-    if(&pair->list == bucket->first && &pair->list == bucket->last)
-        bucket->first = bucket->last = &hashtable->list;
+/* returns 0 on success, -1 if key was not found */
+static int hashtable_do_del(hashtable_t *hashtable, const char *key,
+                            size_t len, size_t hash, int hashed)
+{
+    pair_t *pair;
+    slot_t *slot;
 
-    else if(&pair->list == bucket->first)
-        bucket->first = pair->list.next;
+    if(!hashtable->slots)
+    {
+        pair = hashtable_find_small(hashtable, key, len);
+        if(!pair)
+            return -1;
+    }
+    else
+    {
+        if(!hashed)
+            hash = hash_str(key, len);
 
-    else if(&pair->list == bucket->last)
-        bucket->last = pair->list.prev;
+        slot = hashtable_find_slot(hashtable, key, len, hash);
+        pair = slot->pair;
+        if(!pair)
+            return -1;
+
+        hashtable_remove_slot(hashtable, slot);
+    }
 
     list_remove(&pair->list);
     json_decref(pair->value);
 
-    jsonp_free(pair);
+    jsonp_arena_pool_free(hashtable->arena, pair, pair_size(pair->len));
     hashtable->size--;
+    hashtable->revision++;
 
     return 0;
 }
@@ -140,127 +196,193 @@ static void hashtable_do_clear(hashtable_t *hashtable)
         next = list->next;
         pair = list_to_pair(list);
         json_decref(pair->value);
-        jsonp_free(pair);
+        jsonp_arena_pool_free(hashtable->arena, pair, pair_size(pair->len));
     }
 }
 
-static int hashtable_do_rehash(hashtable_t *hashtable)
+static void insert_to_slots(slot_t *slots, size_t mask,
+                            size_t hash, pair_t *pair)
 {
-    list_t *list, *next;
-    pair_t *pair;
-    size_t i, index, new_size;
+    size_t index = hash & mask;
 
-    jsonp_free(hashtable->buckets);
+    while(slots[index].pair)
+        index = (index + 1) & mask;
 
-    hashtable->order++;
-    new_size = hashsize(hashtable->order);
+    slots[index].hash = hash;
+    slots[index].pair = pair;
+}
 
-    hashtable->buckets = jsonp_malloc(new_size * sizeof(bucket_t));
-    if(!hashtable->buckets)
-        return -1;
+/* Doubles the slots, or creates them when a small table outgrows
+   HASHTABLE_SMALL_SIZE */
+static int hashtable_do_rehash(hashtable_t *hashtable)
+{
+    slot_t *old_slots, *slots;
+    list_t *list;
+    size_t i, order, old_size;
 
-    for(i = 0; i < hashsize(hashtable->order); i++)
+    old_slots = hashtable->slots;
+    if(old_slots)
     {
-        hashtable->buckets[i].first = hashtable->buckets[i].last =
-            &hashtable->list;
+        old_size = hashsize(hashtable->order);
+        order = hashtable->order + 1;
+    }
+    else
+    {
+        old_size = 0;
+        for(order = 3; (hashtable->size + 1) * 2 > hashsize(order); order++)
+            ;
     }
 
-    list = hashtable->list.next;
-    list_init(&hashtable->list);
+    slots = jsonp_arena_malloc(hashtable->arena, hashsize(order) * sizeof(slot_t));
+    if(!slots)
+        return -1;
 
-    for(; list != &hashtable->list; list = next) {
-        next = list->next;
-        pair = list_to_pair(list);
-        index = pair->hash % new_size;
-        insert_to_bucket(hashtable, &hashtable->buckets[index], &pair->list);
+    memset(slots, 0, hashsize(order) * sizeof(slot_t));
+
+    for(i = 0; i < old_size; i++)
+    {
+        if(old_slots[i].pair)
+            insert_to_slots(slots, hashmask(order),
+                            old_slots[i].hash, old_slots[i].pair);
+    }
+
+    if(!old_slots)
+    {
+        for(list = hashtable->list.next; list != &hashtable->list; list = list->next)
+        {
+            pair_t *pair = list_to_pair(list);
+            insert_to_slots(slots, hashmask(order),
+                            hash_str(pair->key, pair->len), pair);
+        }
     }
 
+    jsonp_arena_free(hashtable->arena, old_slots);
+    hashtable->slots = slots;
+    hashtable->order = order;
     return 0;
 }
 
 
-int hashtable_init(hashtable_t *hashtable)
+int hashtable_init(hashtable_t *hashtable, struct jsonp_arena *arena)
 {
-    size_t i;
-
     hashtable->size = 0;
-    hashtable->order = 3;
-    hashtable->buckets = jsonp_malloc(hashsize(hashtable->order) * sizeof(bucket_t));
-    if(!hashtable->buckets)
-        return -1;
-
+    hashtable->revision = 0;
+    hashtable->order = 0;
+    hashtable->arena = arena;
+    hashtable->slots = NULL;
     list_init(&hashtable->list);
 
-    for(i = 0; i < hashsize(hashtable->order); i++)
-    {
-        hashtable->buckets[i].first = hashtable->buckets[i].last =
-            &hashtable->list;
-    }
-
     return 0;
 }
 
 void hashtable_close(hashtable_t *hashtable)
 {
     hashtable_do_clear(hashtable);
-    jsonp_free(hashtable->buckets);
+    jsonp_arena_free(hashtable->arena, hashtable->slots);
+}
+
+static pair_t *new_pair(hashtable_t *hashtable, const char *key,
+                        size_t len, json_t *value)
+{
+    pair_t *pair = jsonp_arena_pool_malloc(hashtable->arena, pair_size(len));
+    if(!pair)
+        return NULL;
+
+    pair->len = len;
+    memcpy(pair->key, key, len + 1);
+    pair->value = value;
+    list_insert(&hashtable->list, &pair->list);
+
+    hashtable->size++;
+    hashtable->revision++;
+    return pair;
 }
 
-int hashtable_set(hashtable_t *hashtable,
-                  const char *key, size_t serial,
-                  json_t *value)
+static int hashtable_do_set(hashtable_t *hashtable, const char *key,
+                            size_t len, size_t hash, int hashed,
+                            json_t *value)
 {
     pair_t *pair;
-    bucket_t *bucket;
-    size_t hash, index;
+    slot_t *slot;
+
+    if(!hashtable->slots)
+    {
+        pair = hashtable_find_small(hashtable, key, len);
+        if(pair)
+        {
+            json_decref(pair->value);
+            pair->value = value;
+            return 0;
+        }
+
+        if(hashtable->size < HASHTABLE_SMALL_SIZE)
+            return new_pair(hashtable, key, len, value) ? 0 : -1;
 
-    /* rehash if the load ratio exceeds 1 */
-    if(hashtable->size >= hashsize(hashtable->order))
         if(hashtable_do_rehash(hashtable))
             return -1;
+    }
+
+    if(!hashed)
+        hash = hash_str(key, len);
 
-    hash = hash_str(key);
-    index = hash & hashmask(hashtable->order);
-    bucket = &hashtable->buckets[index];
-    pair = hashtable_find_pair(hashtable, bucket, key, hash);
+    slot = hashtable_find_slot(hashtable, key, len, hash);
 
-    if(pair)
+    if(slot->pair)
     {
+        pair = slot->pair;
         json_decref(pair->value);
         pair->value = value;
+        return 0;
     }
-    else
+
+    if(hashtable_full(hashtable))
     {
-        /* offsetof(...) returns the size of pair_t without the last,
-           flexible member. This way, the correct amount is
-           allocated. */
-        pair = jsonp_malloc(offsetof(pair_t, key) + strlen(key) + 1);
-        if(!pair)
+        if(hashtable_do_rehash(hashtable))
             return -1;
+        slot = hashtable_find_slot(hashtable, key, len, hash);
+    }
 
-        pair->hash = hash;
-        pair->serial = serial;
-        strcpy(pair->key, key);
-        pair->value = value;
-        list_init(&pair->list);
+    pair = new_pair(hashtable, key, len, value);
+    if(!pair)
+        return -1;
 
-        insert_to_bucket(hashtable, bucket, &pair->list);
+    slot->hash = hash;
+    slot->pair = pair;
 
-        hashtable->size++;
-    }
     return 0;
 }
 
+size_t hashtable_hash(const char *key, size_t len)
+{
+    return hash_str(key, len);
+}
+
+int hashtable_set(hashtable_t *hashtable, const char *key, json_t *value)
+{
+    /* The length is needed for hashing, comparing and copying the key,
+       so only measure it once */
+    return hashtable_do_set(hashtable, key, strlen(key), 0, 0, value);
+}
+
+int hashtable_set_hashed(hashtable_t *hashtable, const char *key,
+                         size_t len, size_t hash, json_t *value)
+{
+    return hashtable_do_set(hashtable, key, len, hash, 1, value);
+}
+
 void *hashtable_get(hashtable_t *hashtable, const char *key)
 {
-    pair_t *pair;
-    size_t hash;
-    bucket_t *bucket;
+    pair_t *pair = hashtable_find_pair(hashtable, key, strlen(key), 0, 0);
+    if(!pair)
+        return NULL;
 
-    hash = hash_str(key);
-    bucket = &hashtable->buckets[hash & hashmask(hashtable->order)];
+    return pair->value;
+}
 
-    pair = hashtable_find_pair(hashtable, bucket, key, hash);
+void *hashtable_get_hashed(hashtable_t *hashtable, const char *key,
+                           size_t len, size_t hash)
+{
+    pair_t *pair = hashtable_find_pair(hashtable, key, len, hash, 1);
     if(!pair)
         return NULL;
 
@@ -269,24 +391,25 @@ void *hashtable_get(hashtable_t *hashtable, const char *key)
 
 int hashtable_del(hashtable_t *hashtable, const char *key)
 {
-    size_t hash = hash_str(key);
-    return hashtable_do_del(hashtable, key, hash);
+    return hashtable_do_del(hashtable, key, strlen(key), 0, 0);
 }
 
-void hashtable_clear(hashtable_t *hashtable)
+int hashtable_del_hashed(hashtable_t *hashtable, const char *key,
+                         size_t len, size_t hash)
 {
-    size_t i;
+    return hashtable_do_del(hashtable, key, len, hash, 1);
+}
 
+void hashtable_clear(hashtable_t *hashtable)
+{
     hashtable_do_clear(hashtable);
 
-    for(i = 0; i < hashsize(hashtable->order); i++)
-    {
-        hashtable->buckets[i].first = hashtable->buckets[i].last =
-            &hashtable->list;
-    }
+    if(hashtable->slots)
+        memset(hashtable->slots, 0, hashsize(hashtable->order) * sizeof(slot_t));
 
     list_init(&hashtable->list);
     hashtable->size = 0;
+    hashtable->revision++;
 }
 
 void *hashtable_iter(hashtable_t *hashtable)
@@ -296,14 +419,7 @@ void *hashtable_iter(hashtable_t *hashtable)
 
 void *hashtable_iter_at(hashtable_t *hashtable, const char *key)
 {
-    pair_t *pair;
-    size_t hash;
-    bucket_t *bucket;
-
-    hash = hash_str(key);
-    bucket = &hashtable->buckets[hash & hashmask(hashtable->order)];
-
-    pair = hashtable_find_pair(hashtable, bucket, key, hash);
+    pair_t *pair = hashtable_find_pair(hashtable, key, strlen(key), 0, 0);
     if(!pair)
         return NULL;
 
@@ -324,12 +440,6 @@ void *hashtable_iter_key(void *iter)
     return pair->key;
 }
 
-size_t hashtable_iter_serial(void *iter)
-{
-    pair_t *pair = list_to_pair((list_t *)iter);
-    return pair->serial;
-}
-
 void *hashtable_iter_value(void *iter)
 {
     pair_t *pair = list_to_pair((list_t *)iter);
@@ -15,25 +15,31 @@ struct hashtable_list {
 
 /* "pair" may be a bit confusing a name, but think of it as a
    key-value pair. In this case, it just encodes some extra data,
-   too */
+   too. Pairs are linked in insertion order and never move, so
+   iterators stay valid while other keys are added or removed. */
 struct hashtable_pair {
-    size_t hash;
     struct hashtable_list list;
     json_t *value;
-    size_t serial;
+    size_t len;
     char key[1];
 };
 
-struct hashtable_bucket {
-    struct hashtable_list *first;
-    struct hashtable_list *last;
+/* The index is an open addressing table with linear probing. Slots
+   keep the hash of their pair, so probing only touches a pair when
+   the hashes match. An empty slot has pair == NULL. Tables with only
+   a few keys have no slots and are searched through the list. */
+struct hashtable_slot {
+    size_t hash;
+    struct hashtable_pair *pair;
 };
 
 typedef struct hashtable {
     size_t size;
-    struct hashtable_bucket *buckets;
-    size_t order;  /* hashtable has pow(2, order) buckets */
+    size_t revision;  /* changes whenever a pair is added or removed */
+    struct hashtable_slot *slots;  /* NULL while the table is small */
+    size_t order;  /* hashtable has pow(2, order) slots */
     struct hashtable_list list;
+    struct jsonp_arena *arena;
 } hashtable_t;
 
 
@@ -45,13 +51,14 @@ typedef struct hashtable {
  * hashtable_init - Initialize a hashtable object
  *
  * @hashtable: The (statically allocated) hashtable object
+ * @arena: The arena to allocate slots and pairs from, or NULL
  *
  * Initializes a statically allocated hashtable object. The object
  * should be cleared with hashtable_close when it's no longer used.
  *
  * Returns 0 on success, -1 on error (out of memory).
  */
-int hashtable_init(hashtable_t *hashtable);
+int hashtable_init(hashtable_t *hashtable, struct jsonp_arena *arena);
 
 /**
  * hashtable_close - Release all resources used by a hashtable object
@@ -67,7 +74,6 @@ void hashtable_close(hashtable_t *hashtable);
  *
  * @hashtable: The hashtable object
  * @key: The key
- * @serial: For addition order of keys
  * @value: The value
  *
  * If a value with the given key already exists, its value is replaced
@@ -77,9 +83,7 @@ void hashtable_close(hashtable_t *hashtable);
  *
  * Returns 0 on success, -1 on failure (out of memory).
  */
-int hashtable_set(hashtable_t *hashtable,
-                  const char *key, size_t serial,
-                  json_t *value);
+int hashtable_set(hashtable_t *hashtable, const char *key, json_t *value);
 
 /**
  * hashtable_get - Get a value associated with a key
@@ -101,6 +105,49 @@ void *hashtable_get(hashtable_t *hashtable, const char *key);
  */
 int hashtable_del(hashtable_t *hashtable, const char *key);
 
+/**
+ * hashtable_hash - Hash a key
+ *
+ * @key: The key
+ * @len: Length of the key in bytes
+ *
+ * Returns the hash that the *_hashed functions below expect. The
+ * result is only valid as long as the hash seed does not change.
+ */
+size_t hashtable_hash(const char *key, size_t len);
+
+/**
+ * hashtable_set_hashed - Add/modify value with a precomputed hash
+ *
+ * @hashtable: The hashtable object
+ * @key: The key
+ * @len: Length of the key in bytes
+ * @hash: Hash of the key, as returned by hashtable_hash()
+ * @value: The value
+ *
+ * Like hashtable_set(), but doesn't measure or hash the key.
+ *
+ * Returns 0 on success, -1 on failure (out of memory).
+ */
+int hashtable_set_hashed(hashtable_t *hashtable, const char *key,
+                         size_t len, size_t hash, json_t *value);
+
+/**
+ * hashtable_get_hashed - Get a value with a precomputed hash
+ *
+ * Like hashtable_get(), see hashtable_set_hashed() for the arguments.
+ */
+void *hashtable_get_hashed(hashtable_t *hashtable, const char *key,
+                           size_t len, size_t hash);
+
+/**
+ * hashtable_del_hashed - Remove a value with a precomputed hash
+ *
+ * Like hashtable_del(), see hashtable_set_hashed() for the arguments.
+ */
+int hashtable_del_hashed(hashtable_t *hashtable, const char *key,
+                         size_t len, size_t hash);
+
 /**
  * hashtable_clear - Clear hashtable
  *
@@ -117,7 +164,7 @@ void hashtable_clear(hashtable_t *hashtable);
  *
  * Returns an opaque iterator to the first element in the hashtable.
  * The iterator should be passed to hashtable_iter_* functions.
- * The hashtable items are not iterated over in any particular order.
+ * The hashtable items are iterated over in the order they were added.
  *
  * There's no need to free the iterator in any way. The iterator is
  * valid as long as the item that is referenced by the iterator is not
@@ -156,13 +203,6 @@ void *hashtable_iter_next(hashtable_t *hashtable, void *iter);
  */
 void *hashtable_iter_key(void *iter);
 
-/**
- * hashtable_iter_serial - Retrieve the serial number pointed to by an iterator
- *
- * @iter: The iterator
- */
-size_t hashtable_iter_serial(void *iter);
-
 /**
  * hashtable_iter_value - Retrieve the value pointed by an iterator
  *
@@ -128,6 +128,7 @@ typedef struct {
 
 void json_object_seed(size_t seed);
 size_t json_object_size(const json_t *object);
+size_t json_object_revision(const json_t *object);
 json_t *json_object_get(const json_t *object, const char *key);
 int json_object_set_new(json_t *object, const char *key, json_t *value);
 int json_object_set_new_nocheck(json_t *object, const char *key, json_t *value);
@@ -172,6 +173,23 @@ int json_object_iter_set(json_t *object, void *iter, json_t *value)
     return json_object_iter_set_new(object, iter, json_incref(value));
 }
 
+/* object keys with a precomputed hash */
+
+typedef struct json_key_t json_key_t;
+
+json_key_t *json_key(const char *key);
+void json_key_free(json_key_t *key);
+const char *json_key_string(const json_key_t *key);
+json_t *json_object_get_key(const json_t *object, const json_key_t *key);
+int json_object_set_new_key(json_t *object, const json_key_t *key, json_t *value);
+int json_object_del_key(json_t *object, const json_key_t *key);
+
+static JSON_INLINE
+int json_object_set_key(json_t *object, const json_key_t *key, json_t *value)
+{
+    return json_object_set_new_key(object, key, json_incref(value));
+}
+
 size_t json_array_size(const json_t *array);
 json_t *json_array_get(const json_t *array, size_t index);
 int json_array_set_new(json_t *array, size_t index, json_t *value);
@@ -180,6 +198,7 @@ int json_array_insert_new(json_t *array, size_t index, json_t *value);
 int json_array_remove(json_t *array, size_t index);
 int json_array_clear(json_t *array);
 int json_array_extend(json_t *array, json_t *other);
+int json_array_reserve(json_t *array, size_t size);
 
 static JSON_INLINE
 int json_array_set(json_t *array, size_t ind, json_t *value)
@@ -223,6 +242,23 @@ int json_unpack(json_t *root, const char *fmt, ...);
 int json_unpack_ex(json_t *root, json_error_t *error, size_t flags, const char *fmt, ...);
 int json_vunpack_ex(json_t *root, json_error_t *error, size_t flags, const char *fmt, va_list ap);
 
+/* Arguments for json_pack_callback() and json_unpack_callback(), for
+   callers that can't pass C varargs */
+
+typedef union {
+    const char *string;     /* 's', 'k' (unpack object key) */
+    int integer;            /* 'b', 'i', '#' */
+    json_int_t json_int;    /* 'I' */
+    double real;            /* 'f' */
+    json_t *json;           /* 'O', 'o' */
+    void *target;           /* all unpack targets */
+} json_arg_t;
+
+typedef int (*json_arg_callback_t)(char type, json_arg_t *arg, void *data);
+
+json_t *json_pack_callback(json_error_t *error, size_t flags, const char *fmt, json_arg_callback_t callback, void *data);
+int json_unpack_callback(json_t *root, json_error_t *error, size_t flags, const char *fmt, json_arg_callback_t callback, void *data);
+
 
 /* equality */
 
@@ -235,12 +271,29 @@ json_t *json_copy(json_t *value);
 json_t *json_deep_copy(const json_t *value);
 
 
+/* JSON Pointer (RFC 6901) */
+
+json_t *json_path_get(const json_t *json, const char *path);
+
+#define JSON_PATH_CREATE    0x1
+
+int json_path_set_new(json_t *json, const char *path, json_t *value, size_t flags);
+
+static JSON_INLINE
+int json_path_set(json_t *json, const char *path, json_t *value, size_t flags)
+{
+    return json_path_set_new(json, path, json_incref(value), flags);
+}
+
+
 /* decoding */
 
 #define JSON_REJECT_DUPLICATES  0x1
 #define JSON_DISABLE_EOF_CHECK  0x2
 #define JSON_DECODE_ANY         0x4
 #define JSON_DECODE_INT_AS_REAL 0x8
+#define JSON_MAP_FILE           0x10
+#define JSON_ARENA_ALLOC        0x20
 
 typedef size_t (*json_load_callback_t)(void *buffer, size_t buflen, void *data);
 
@@ -267,6 +320,7 @@ char *json_dumps(const json_t *json, size_t flags);
 int json_dumpf(const json_t *json, FILE *output, size_t flags);
 int json_dump_file(const json_t *json, const char *path, size_t flags);
 int json_dump_callback(const json_t *json, json_dump_callback_t callback, void *data, size_t flags);
+size_t json_dump_size(const json_t *json, size_t flags);
 
 /* custom memory allocation */
 
@@ -274,6 +328,7 @@ typedef void *(*json_malloc_t)(size_t);
 typedef void (*json_free_t)(void *);
 
 void json_set_alloc_funcs(json_malloc_t malloc_fn, json_free_t free_fn);
+void json_pool_flush(void);
 
 #ifdef __cplusplus
 }
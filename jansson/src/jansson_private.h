@@ -34,8 +34,6 @@
 typedef struct {
     json_t json;
     hashtable_t hashtable;
-    size_t serial;
-    int visited;
 } json_object_t;
 
 typedef struct {
@@ -43,22 +41,25 @@ typedef struct {
     size_t size;
     size_t entries;
     json_t **table;
-    int visited;
+    struct jsonp_arena *arena;
 } json_array_t;
 
 typedef struct {
     json_t json;
     char *value;
+    struct jsonp_arena *arena;
 } json_string_t;
 
 typedef struct {
     json_t json;
     double value;
+    struct jsonp_arena *arena;
 } json_real_t;
 
 typedef struct {
     json_t json;
     json_int_t value;
+    struct jsonp_arena *arena;
 } json_integer_t;
 
 #define json_to_object(json_)  container_of(json_, json_object_t, json)
@@ -74,9 +75,10 @@ void jsonp_error_set(json_error_t *error, int line, int column,
 void jsonp_error_vset(json_error_t *error, int line, int column,
                       size_t position, const char *msg, va_list ap);
 
-/* Locale independent string<->double conversions */
+/* Locale independent string<->number conversions */
 int jsonp_strtod(strbuffer_t *strbuffer, double *out);
 int jsonp_dtostr(char *buffer, size_t size, double value);
+int jsonp_itostr(char *buffer, size_t size, json_int_t value);
 
 /* Wrappers for custom memory functions */
 void* jsonp_malloc(size_t size);
@@ -84,6 +86,35 @@ void jsonp_free(void *ptr);
 char *jsonp_strndup(const char *str, size_t length);
 char *jsonp_strdup(const char *str);
 
+/* For small blocks of fixed size, which are cached per thread. The size
+   passed to jsonp_pool_free() must be the one passed to
+   jsonp_pool_malloc(). */
+void *jsonp_pool_malloc(size_t size);
+void jsonp_pool_free(void *ptr, size_t size);
+
+/* Arena for the values of one decoded document. Allocations are served
+   from the arena until it's closed, and from the heap after that. The
+   arena is freed as a whole when its last reference is gone: one is held
+   by the decoder and one by every value allocated in it. */
+typedef struct jsonp_arena jsonp_arena_t;
+
+jsonp_arena_t *jsonp_arena_new(void);
+void *jsonp_arena_malloc(jsonp_arena_t *arena, size_t size);
+void jsonp_arena_free(jsonp_arena_t *arena, void *ptr);
+void *jsonp_arena_pool_malloc(jsonp_arena_t *arena, size_t size);
+void jsonp_arena_pool_free(jsonp_arena_t *arena, void *ptr, size_t size);
+char *jsonp_arena_strndup(jsonp_arena_t *arena, const char *str, size_t len);
+jsonp_arena_t *jsonp_arena_incref(jsonp_arena_t *arena);
+void jsonp_arena_decref(jsonp_arena_t *arena);
+void jsonp_arena_close(jsonp_arena_t *arena);
+
+/* Value constructors that allocate from an arena, which may be NULL */
+json_t *jsonp_object(jsonp_arena_t *arena);
+json_t *jsonp_array(jsonp_arena_t *arena);
+json_t *jsonp_stringn_nocheck(jsonp_arena_t *arena, const char *value, size_t len);
+json_t *jsonp_integer(jsonp_arena_t *arena, json_int_t value);
+json_t *jsonp_real(jsonp_arena_t *arena, double value);
+
 /* Windows compatibility */
 #ifdef _WIN32
 #define snprintf _snprintf
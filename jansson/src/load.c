@@ -16,6 +16,15 @@
 #include <string.h>
 #include <assert.h>
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "jansson.h"
 #include "jansson_private.h"
 #include "strbuffer.h"
@@ -42,14 +51,16 @@
 #define l_isxdigit(c) \
     (l_isdigit(c) || ('A' <= (c) && (c) <= 'F') || ('a' <= (c) && (c) <= 'f'))
 
-/* Read one byte from stream, convert to unsigned char, then int, and
-   return. return EOF on end of file. This corresponds to the
-   behaviour of fgetc(). */
-typedef int (*get_func)(void *data);
+/* Point *chunk to the next block of input and return its length.
+   Return 0 on end of file. The block must stay valid until the next
+   call. */
+typedef size_t (*fill_func)(void *data, const char **chunk);
 
 typedef struct {
-    get_func get;
+    fill_func fill;
     void *data;
+    const char *chunk;
+    const char *chunk_end;
     char buffer[5];
     size_t buffer_pos;
     int state;
@@ -61,9 +72,15 @@ typedef struct {
 typedef struct {
     stream_t stream;
     strbuffer_t saved_text;
+    char *decoded;          /* reused for the value of every string */
+    size_t decoded_size;
+    jsonp_arena_t *arena;   /* see JSON_ARENA_ALLOC */
     int token;
     union {
-        char *string;
+        struct {
+            char *val;      /* points to decoded */
+            size_t len;
+        } string;
         json_int_t integer;
         double real;
     } value;
@@ -132,10 +149,12 @@ static void error_set(json_error_t *error, const lex_t *lex,
 /*** lexical analyzer ***/
 
 static void
-stream_init(stream_t *stream, get_func get, void *data)
+stream_init(stream_t *stream, fill_func fill, void *data)
 {
-    stream->get = get;
+    stream->fill = fill;
     stream->data = data;
+    stream->chunk = NULL;
+    stream->chunk_end = NULL;
     stream->buffer[0] = '\0';
     stream->buffer_pos = 0;
 
@@ -145,6 +164,23 @@ stream_init(stream_t *stream, get_func get, void *data)
     stream->position = 0;
 }
 
+/* Read one byte from the current block, refilling it as needed.
+   Return EOF on end of file. */
+static int stream_next(stream_t *stream)
+{
+    if(stream->chunk == stream->chunk_end)
+    {
+        size_t len = stream->fill(stream->data, &stream->chunk);
+        if(len == 0 || len == (size_t)-1) {
+            stream->chunk_end = stream->chunk;
+            return EOF;
+        }
+        stream->chunk_end = stream->chunk + len;
+    }
+
+    return (unsigned char)*stream->chunk++;
+}
+
 static int stream_get(stream_t *stream, json_error_t *error)
 {
     int c;
@@ -152,9 +188,19 @@ static int stream_get(stream_t *stream, json_error_t *error)
     if(stream->state != STREAM_STATE_OK)
         return stream->state;
 
-    if(!stream->buffer[stream->buffer_pos])
+    /* Fast path: a plain ASCII byte is taken straight from the block */
+    if(!stream->buffer[stream->buffer_pos] &&
+       stream->chunk != stream->chunk_end &&
+       (unsigned char)*stream->chunk < 0x80)
     {
-        c = stream->get(stream->data);
+        c = *stream->chunk++;
+        stream->buffer[0] = c;
+        stream->buffer[1] = '\0';
+        stream->buffer_pos = 0;
+    }
+    else if(!stream->buffer[stream->buffer_pos])
+    {
+        c = stream_next(stream);
         if(c == EOF) {
             stream->state = STREAM_STATE_EOF;
             return STREAM_STATE_EOF;
@@ -175,7 +221,7 @@ static int stream_get(stream_t *stream, json_error_t *error)
             assert(count >= 2);
 
             for(i = 1; i < count; i++)
-                stream->buffer[i] = stream->get(stream->data);
+                stream->buffer[i] = stream_next(stream);
 
             if(!utf8_check_full(stream->buffer, count, NULL))
                 goto out;
@@ -269,6 +315,87 @@ static void lex_unget_unsave(lex_t *lex, int c)
     }
 }
 
+/* Skip whitespace that is waiting in the current block in one go,
+   keeping track of lines and columns like stream_get() would */
+static void lex_skip_space(lex_t *lex)
+{
+    stream_t *stream = &lex->stream;
+    const char *p = stream->chunk;
+
+    if(stream->state != STREAM_STATE_OK ||
+       stream->buffer[stream->buffer_pos] != '\0')
+        return;
+
+    while(p != stream->chunk_end)
+    {
+        if(*p == '\n') {
+            stream->line++;
+            stream->last_column = stream->column;
+            stream->column = 0;
+        }
+        else if(*p == ' ' || *p == '\t' || *p == '\r')
+            stream->column++;
+        else
+            break;
+        p++;
+    }
+
+    stream->position += p - stream->chunk;
+    stream->chunk = p;
+}
+
+/* Save the run of plain string bytes that is waiting in the current
+   block in one go. Escapes, control characters, multi-byte UTF-8 and the
+   closing quote are left to lex_get_save(). */
+static void lex_save_plain(lex_t *lex)
+{
+    stream_t *stream = &lex->stream;
+    size_t length;
+
+    if(stream->state != STREAM_STATE_OK ||
+       stream->buffer[stream->buffer_pos] != '\0')
+        return;
+
+    length = utf8_plain_length(stream->chunk,
+                               stream->chunk_end - stream->chunk);
+    if(length == 0)
+        return;
+
+    strbuffer_append_bytes(&lex->saved_text, stream->chunk, length);
+    stream->chunk += length;
+    stream->position += length;
+    stream->column += length;
+}
+
+/* Save the run of digits that is waiting in the current block in one
+   go, accumulating their decimal value. The value wraps around if there
+   are too many digits; *count tells the caller whether it can be used. */
+static void lex_save_digits(lex_t *lex, unsigned long long *value, int *count)
+{
+    stream_t *stream = &lex->stream;
+    const char *p = stream->chunk;
+    size_t length;
+
+    if(stream->state != STREAM_STATE_OK ||
+       stream->buffer[stream->buffer_pos] != '\0')
+        return;
+
+    while(p != stream->chunk_end && l_isdigit(*p)) {
+        *value = *value * 10 + (*p - '0');
+        p++;
+    }
+
+    length = p - stream->chunk;
+    if(length == 0)
+        return;
+
+    strbuffer_append_bytes(&lex->saved_text, stream->chunk, length);
+    *count += (int)length;
+    stream->chunk = p;
+    stream->position += length;
+    stream->column += length;
+}
+
 static void lex_save_cached(lex_t *lex)
 {
     while(lex->stream.buffer[lex->stream.buffer_pos] != '\0')
@@ -309,10 +436,11 @@ static void lex_scan_string(lex_t *lex, json_error_t *error)
     const char *p;
     char *t;
     int i;
+    int escaped = 0;
 
-    lex->value.string = NULL;
     lex->token = TOKEN_INVALID;
 
+    lex_save_plain(lex);
     c = lex_get_save(lex, error);
 
     while(c != '"') {
@@ -335,6 +463,7 @@ static void lex_scan_string(lex_t *lex, json_error_t *error)
         }
 
         else if(c == '\\') {
+            escaped = 1;
             c = lex_get_save(lex, error);
             if(c == 'u') {
                 c = lex_get_save(lex, error);
@@ -354,8 +483,10 @@ static void lex_scan_string(lex_t *lex, json_error_t *error)
                 goto out;
             }
         }
-        else
+        else {
+            lex_save_plain(lex);
             c = lex_get_save(lex, error);
+        }
     }
 
     /* the actual value is at most of the same length as the source
@@ -365,18 +496,32 @@ static void lex_scan_string(lex_t *lex, json_error_t *error)
          - two \uXXXX escapes (length 12) forming an UTF-16 surrogate pair
            are converted to 4 bytes
     */
-    lex->value.string = jsonp_malloc(lex->saved_text.length + 1);
-    if(!lex->value.string) {
-        /* this is not very nice, since TOKEN_INVALID is returned */
-        goto out;
+    if(lex->decoded_size < lex->saved_text.length + 1) {
+        size_t size = max(lex->decoded_size * 2, lex->saved_text.length + 1);
+        char *decoded = jsonp_malloc(size);
+        if(!decoded) {
+            /* this is not very nice, since TOKEN_INVALID is returned */
+            return;
+        }
+
+        jsonp_free(lex->decoded);
+        lex->decoded = decoded;
+        lex->decoded_size = size;
     }
 
     /* the target */
-    t = lex->value.string;
+    t = lex->decoded;
 
     /* + 1 to skip the " */
     p = strbuffer_value(&lex->saved_text) + 1;
 
+    if(!escaped) {
+        /* nothing to decode, copy all but the quotes */
+        memcpy(t, p, lex->saved_text.length - 2);
+        t += lex->saved_text.length - 2;
+        p += lex->saved_text.length - 2;
+    }
+
     while(*p != '"') {
         if(*p == '\\') {
             p++;
@@ -451,13 +596,20 @@ static void lex_scan_string(lex_t *lex, json_error_t *error)
             *(t++) = *(p++);
     }
     *t = '\0';
+    lex->value.string.val = lex->decoded;
+    lex->value.string.len = t - lex->decoded;
     lex->token = TOKEN_STRING;
-    return;
 
 out:
-    jsonp_free(lex->value.string);
+    return;
 }
 
+#if JSON_INTEGER_IS_LONG_LONG
+#define JSON_INTEGER_MAX  LLONG_MAX
+#else
+#define JSON_INTEGER_MAX  LONG_MAX
+#endif
+
 #ifndef JANSSON_USING_CMAKE /* disabled if using cmake */
 #if JSON_INTEGER_IS_LONG_LONG
 #ifdef _MSC_VER  /* Microsoft Visual Studio */
@@ -475,13 +627,19 @@ static int lex_scan_number(lex_t *lex, int c, json_error_t *error)
     const char *saved_text;
     char *end;
     double value;
+    int negative = 0;
+    unsigned long long magnitude = 0;
+    int digits = 0;
 
     lex->token = TOKEN_INVALID;
 
-    if(c == '-')
+    if(c == '-') {
+        negative = 1;
         c = lex_get_save(lex, error);
+    }
 
     if(c == '0') {
+        digits = 1;
         c = lex_get_save(lex, error);
         if(l_isdigit(c)) {
             lex_unget_unsave(lex, c);
@@ -489,9 +647,12 @@ static int lex_scan_number(lex_t *lex, int c, json_error_t *error)
         }
     }
     else if(l_isdigit(c)) {
-        c = lex_get_save(lex, error);
-        while(l_isdigit(c))
+        while(l_isdigit(c)) {
+            magnitude = magnitude * 10 + (c - '0');
+            digits++;
+            lex_save_digits(lex, &magnitude, &digits);
             c = lex_get_save(lex, error);
+        }
     }
     else {
         lex_unget_unsave(lex, c);
@@ -503,6 +664,16 @@ static int lex_scan_number(lex_t *lex, int c, json_error_t *error)
 
         lex_unget_unsave(lex, c);
 
+        /* Up to 18 digits can't have wrapped around, only the range of
+           json_int_t has to be checked. Anything else goes through
+           strtoll() for the overflow check. */
+        if(digits <= 18 && magnitude <= JSON_INTEGER_MAX) {
+            lex->token = TOKEN_INTEGER;
+            lex->value.integer = negative ? -(json_int_t)magnitude
+                                          : (json_int_t)magnitude;
+            return 0;
+        }
+
         saved_text = strbuffer_value(&lex->saved_text);
 
         errno = 0;
@@ -571,11 +742,7 @@ static int lex_scan(lex_t *lex, json_error_t *error)
 
     strbuffer_clear(&lex->saved_text);
 
-    if(lex->token == TOKEN_STRING) {
-        jsonp_free(lex->value.string);
-        lex->value.string = NULL;
-    }
-
+    lex_skip_space(lex);
     c = lex_get(lex, error);
     while(c == ' ' || c == '\t' || c == '\n' || c == '\r')
         c = lex_get(lex, error);
@@ -635,42 +802,60 @@ out:
     return lex->token;
 }
 
-static char *lex_steal_string(lex_t *lex)
+/* Copy the current string token to buffer, or to a new allocation if it
+   doesn't fit. The string token itself is overwritten by the next one. */
+static char *lex_copy_string(lex_t *lex, char *buffer, size_t size)
 {
-    char *result = NULL;
-    if(lex->token == TOKEN_STRING)
-    {
-        result = lex->value.string;
-        lex->value.string = NULL;
+    char *result = buffer;
+
+    if(lex->value.string.len >= size) {
+        result = jsonp_malloc(lex->value.string.len + 1);
+        if(!result)
+            return NULL;
     }
+
+    memcpy(result, lex->value.string.val, lex->value.string.len + 1);
     return result;
 }
 
-static int lex_init(lex_t *lex, get_func get, void *data)
+static int lex_init(lex_t *lex, fill_func fill, void *data)
 {
-    stream_init(&lex->stream, get, data);
+    stream_init(&lex->stream, fill, data);
     if(strbuffer_init(&lex->saved_text))
         return -1;
 
+    lex->decoded = NULL;
+    lex->decoded_size = 0;
+    lex->arena = NULL;
     lex->token = TOKEN_INVALID;
     return 0;
 }
 
 static void lex_close(lex_t *lex)
 {
-    if(lex->token == TOKEN_STRING)
-        jsonp_free(lex->value.string);
+    jsonp_free(lex->decoded);
+    jsonp_arena_close(lex->arena);
     strbuffer_close(&lex->saved_text);
 }
 
 
 /*** parser ***/
 
+/* Keys up to this length are kept on the stack while their value is
+   parsed */
+#define KEY_BUFFER_LENGTH  64
+
+static void free_key(char *key, char *buffer)
+{
+    if(key != buffer)
+        jsonp_free(key);
+}
+
 static json_t *parse_value(lex_t *lex, size_t flags, json_error_t *error);
 
 static json_t *parse_object(lex_t *lex, size_t flags, json_error_t *error)
 {
-    json_t *object = json_object();
+    json_t *object = jsonp_object(lex->arena);
     if(!object)
         return NULL;
 
@@ -679,6 +864,7 @@ static json_t *parse_object(lex_t *lex, size_t flags, json_error_t *error)
         return object;
 
     while(1) {
+        char key_buffer[KEY_BUFFER_LENGTH];
         char *key;
         json_t *value;
 
@@ -687,13 +873,13 @@ static json_t *parse_object(lex_t *lex, size_t flags, json_error_t *error)
             goto error;
         }
 
-        key = lex_steal_string(lex);
+        key = lex_copy_string(lex, key_buffer, sizeof(key_buffer));
         if(!key)
-            return NULL;
+            goto error;
 
         if(flags & JSON_REJECT_DUPLICATES) {
             if(json_object_get(object, key)) {
-                jsonp_free(key);
+                free_key(key, key_buffer);
                 error_set(error, lex, "duplicate object key");
                 goto error;
             }
@@ -701,7 +887,7 @@ static json_t *parse_object(lex_t *lex, size_t flags, json_error_t *error)
 
         lex_scan(lex, error);
         if(lex->token != ':') {
-            jsonp_free(key);
+            free_key(key, key_buffer);
             error_set(error, lex, "':' expected");
             goto error;
         }
@@ -709,18 +895,18 @@ static json_t *parse_object(lex_t *lex, size_t flags, json_error_t *error)
         lex_scan(lex, error);
         value = parse_value(lex, flags, error);
         if(!value) {
-            jsonp_free(key);
+            free_key(key, key_buffer);
             goto error;
         }
 
         if(json_object_set_nocheck(object, key, value)) {
-            jsonp_free(key);
+            free_key(key, key_buffer);
             json_decref(value);
             goto error;
         }
 
         json_decref(value);
-        jsonp_free(key);
+        free_key(key, key_buffer);
 
         lex_scan(lex, error);
         if(lex->token != ',')
@@ -743,7 +929,7 @@ error:
 
 static json_t *parse_array(lex_t *lex, size_t flags, json_error_t *error)
 {
-    json_t *array = json_array();
+    json_t *array = jsonp_array(lex->arena);
     if(!array)
         return NULL;
 
@@ -788,7 +974,8 @@ static json_t *parse_value(lex_t *lex, size_t flags, json_error_t *error)
 
     switch(lex->token) {
         case TOKEN_STRING: {
-            json = json_string_nocheck(lex->value.string);
+            json = jsonp_stringn_nocheck(lex->arena, lex->value.string.val,
+                                         lex->value.string.len);
             break;
         }
 
@@ -798,15 +985,15 @@ static json_t *parse_value(lex_t *lex, size_t flags, json_error_t *error)
                     error_set(error, lex, "real number overflow");
                     return NULL;
                 }
-                json = json_real(value);
+                json = jsonp_real(lex->arena, value);
             } else {
-                json = json_integer(lex->value.integer);
+                json = jsonp_integer(lex->arena, lex->value.integer);
             }
             break;
         }
 
         case TOKEN_REAL: {
-            json = json_real(lex->value.real);
+            json = jsonp_real(lex->arena, lex->value.real);
             break;
         }
 
@@ -849,6 +1036,12 @@ static json_t *parse_json(lex_t *lex, size_t flags, json_error_t *error)
 {
     json_t *result;
 
+    if(flags & JSON_ARENA_ALLOC) {
+        lex->arena = jsonp_arena_new();
+        if(!lex->arena)
+            return NULL;
+    }
+
     lex_scan(lex, error);
     if(!(flags & JSON_DECODE_ANY)) {
         if(lex->token != '[' && lex->token != '{') {
@@ -881,28 +1074,26 @@ static json_t *parse_json(lex_t *lex, size_t flags, json_error_t *error)
 typedef struct
 {
     const char *data;
-    int pos;
-} string_data_t;
+    size_t len;
+    size_t pos;
+} buffer_data_t;
 
-static int string_get(void *data)
+static size_t buffer_fill(void *data, const char **chunk)
 {
-    char c;
-    string_data_t *stream = (string_data_t *)data;
-    c = stream->data[stream->pos];
-    if(c == '\0')
-        return EOF;
-    else
-    {
-        stream->pos++;
-        return (unsigned char)c;
-    }
+    buffer_data_t *stream = data;
+    size_t len = stream->len - stream->pos;
+
+    /* The whole buffer is handed out as one block */
+    *chunk = stream->data + stream->pos;
+    stream->pos = stream->len;
+    return len;
 }
 
 json_t *json_loads(const char *string, size_t flags, json_error_t *error)
 {
     lex_t lex;
     json_t *result;
-    string_data_t stream_data;
+    buffer_data_t stream_data;
 
     jsonp_error_init(error, "<string>");
 
@@ -913,8 +1104,9 @@ json_t *json_loads(const char *string, size_t flags, json_error_t *error)
 
     stream_data.data = string;
     stream_data.pos = 0;
+    stream_data.len = strlen(string);
 
-    if(lex_init(&lex, string_get, (void *)&stream_data))
+    if(lex_init(&lex, buffer_fill, (void *)&stream_data))
         return NULL;
 
     result = parse_json(&lex, flags, error);
@@ -923,31 +1115,27 @@ json_t *json_loads(const char *string, size_t flags, json_error_t *error)
     return result;
 }
 
-typedef struct
+static json_t *load_buffer(const char *buffer, size_t buflen, size_t flags, json_error_t *error)
 {
-    const char *data;
-    size_t len;
-    size_t pos;
-} buffer_data_t;
+    lex_t lex;
+    json_t *result;
+    buffer_data_t stream_data;
 
-static int buffer_get(void *data)
-{
-    char c;
-    buffer_data_t *stream = data;
-    if(stream->pos >= stream->len)
-      return EOF;
+    stream_data.data = buffer;
+    stream_data.pos = 0;
+    stream_data.len = buflen;
+
+    if(lex_init(&lex, buffer_fill, (void *)&stream_data))
+        return NULL;
+
+    result = parse_json(&lex, flags, error);
 
-    c = stream->data[stream->pos];
-    stream->pos++;
-    return (unsigned char)c;
+    lex_close(&lex);
+    return result;
 }
 
 json_t *json_loadb(const char *buffer, size_t buflen, size_t flags, json_error_t *error)
 {
-    lex_t lex;
-    json_t *result;
-    buffer_data_t stream_data;
-
     jsonp_error_init(error, "<buffer>");
 
     if (buffer == NULL) {
@@ -955,24 +1143,73 @@ json_t *json_loadb(const char *buffer, size_t buflen, size_t flags, json_error_t
         return NULL;
     }
 
-    stream_data.data = buffer;
-    stream_data.pos = 0;
-    stream_data.len = buflen;
+    return load_buffer(buffer, buflen, flags, error);
+}
 
-    if(lex_init(&lex, buffer_get, (void *)&stream_data))
-        return NULL;
+#define FILE_BUF_LEN 65536
 
-    result = parse_json(&lex, flags, error);
+typedef struct
+{
+    FILE *input;
+    char *data;
+    size_t size;
+} file_data_t;
 
-    lex_close(&lex);
+static size_t file_fill(void *data, const char **chunk)
+{
+    file_data_t *stream = data;
+
+    *chunk = stream->data;
+    if(stream->size == 1)
+    {
+        int c = fgetc(stream->input);
+        if(c == EOF)
+            return 0;
+
+        stream->data[0] = (char)c;
+        return 1;
+    }
+
+    return fread(stream->data, 1, stream->size, stream->input);
+}
+
+static json_t *load_file(FILE *input, int buffered, size_t flags, json_error_t *error)
+{
+    lex_t lex;
+    json_t *result;
+    file_data_t stream_data;
+    char byte;
+
+    stream_data.input = input;
+    if(buffered)
+    {
+        stream_data.data = jsonp_malloc(FILE_BUF_LEN);
+        if(!stream_data.data)
+            return NULL;
+        stream_data.size = FILE_BUF_LEN;
+    }
+    else
+    {
+        stream_data.data = &byte;
+        stream_data.size = 1;
+    }
+
+    if(lex_init(&lex, file_fill, (void *)&stream_data))
+        result = NULL;
+    else
+    {
+        result = parse_json(&lex, flags, error);
+        lex_close(&lex);
+    }
+
+    if(buffered)
+        jsonp_free(stream_data.data);
     return result;
 }
 
 json_t *json_loadf(FILE *input, size_t flags, json_error_t *error)
 {
-    lex_t lex;
     const char *source;
-    json_t *result;
 
     if(input == stdin)
         source = "<stdin>";
@@ -986,18 +1223,101 @@ json_t *json_loadf(FILE *input, size_t flags, json_error_t *error)
         return NULL;
     }
 
-    if(lex_init(&lex, (get_func)fgetc, input))
-        return NULL;
+    /* Reading ahead would swallow whatever follows the JSON text in
+       the caller's stream, so only do that when the whole stream is
+       consumed anyway */
+    return load_file(input, !(flags & JSON_DISABLE_EOF_CHECK), flags, error);
+}
 
-    result = parse_json(&lex, flags, error);
+typedef struct
+{
+    const char *data;
+    size_t size;
+#if defined(_WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} mapped_file_t;
 
-    lex_close(&lex);
-    return result;
+/* Map the whole file into memory. Return -1 if that isn't possible,
+   e.g. for empty files or anything that isn't a regular file; the
+   caller falls back to reading it with stdio then. */
+static int map_file(const char *path, mapped_file_t *file)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER size;
+
+    file->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file->file == INVALID_HANDLE_VALUE)
+        return -1;
+
+    if(!GetFileSizeEx(file->file, &size) || size.QuadPart <= 0 ||
+       (unsigned long long)size.QuadPart > (size_t)-1)
+        goto error;
+
+    file->mapping = CreateFileMappingA(file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!file->mapping)
+        goto error;
+
+    file->data = MapViewOfFile(file->mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!file->data) {
+        CloseHandle(file->mapping);
+        goto error;
+    }
+
+    file->size = (size_t)size.QuadPart;
+    return 0;
+
+error:
+    CloseHandle(file->file);
+    return -1;
+#else
+    struct stat st;
+    void *data;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0)
+        return -1;
+
+    if(fstat(fd, &st) || !S_ISREG(st.st_mode) || st.st_size <= 0 ||
+       (unsigned long long)st.st_size > (size_t)-1)
+    {
+        close(fd);
+        return -1;
+    }
+
+    data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED)
+        return -1;
+
+#if defined(MADV_SEQUENTIAL)
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    file->data = data;
+    file->size = (size_t)st.st_size;
+    return 0;
+#endif
+}
+
+static void unmap_file(mapped_file_t *file)
+{
+#if defined(_WIN32)
+    UnmapViewOfFile(file->data);
+    CloseHandle(file->mapping);
+    CloseHandle(file->file);
+#else
+    munmap((void *)file->data, file->size);
+#endif
 }
 
 json_t *json_load_file(const char *path, size_t flags, json_error_t *error)
 {
     json_t *result;
+    mapped_file_t mapping;
     FILE *fp;
 
     jsonp_error_init(error, path);
@@ -1007,6 +1327,13 @@ json_t *json_load_file(const char *path, size_t flags, json_error_t *error)
         return NULL;
     }
 
+    if((flags & JSON_MAP_FILE) && map_file(path, &mapping) == 0)
+    {
+        result = load_buffer(mapping.data, mapping.size, flags, error);
+        unmap_file(&mapping);
+        return result;
+    }
+
     fp = fopen(path, "rb");
     if(!fp)
     {
@@ -1015,7 +1342,8 @@ json_t *json_load_file(const char *path, size_t flags, json_error_t *error)
         return NULL;
     }
 
-    result = json_loadf(fp, flags, error);
+    /* The file is ours, it's fine to read ahead */
+    result = load_file(fp, 1, flags, error);
 
     fclose(fp);
     return result;
@@ -1026,27 +1354,16 @@ json_t *json_load_file(const char *path, size_t flags, json_error_t *error)
 typedef struct
 {
     char data[MAX_BUF_LEN];
-    size_t len;
-    size_t pos;
     json_load_callback_t callback;
     void *arg;
 } callback_data_t;
 
-static int callback_get(void *data)
+static size_t callback_fill(void *data, const char **chunk)
 {
-    char c;
     callback_data_t *stream = data;
 
-    if(stream->pos >= stream->len) {
-        stream->pos = 0;
-        stream->len = stream->callback(stream->data, MAX_BUF_LEN, stream->arg);
-        if(stream->len == 0 || stream->len == (size_t)-1)
-            return EOF;
-    }
-
-    c = stream->data[stream->pos];
-    stream->pos++;
-    return (unsigned char)c;
+    *chunk = stream->data;
+    return stream->callback(stream->data, MAX_BUF_LEN, stream->arg);
 }
 
 json_t *json_load_callback(json_load_callback_t callback, void *arg, size_t flags, json_error_t *error)
@@ -1067,7 +1384,7 @@ json_t *json_load_callback(json_load_callback_t callback, void *arg, size_t flag
         return NULL;
     }
 
-    if(lex_init(&lex, (get_func)callback_get, &stream_data))
+    if(lex_init(&lex, callback_fill, &stream_data))
         return NULL;
 
     result = parse_json(&lex, flags, error);
@@ -49,8 +49,287 @@ char *jsonp_strdup(const char *str)
     return new_str;
 }
 
+/* pool */
+
+/* Values and object pairs are small and of a few fixed sizes. With the
+   default allocator, every thread keeps freed blocks of up to
+   POOL_CLASSES * POOL_GRANULE bytes in free lists, one per size class,
+   so that building and dropping small values doesn't go to malloc() and
+   free() each time. Custom allocators always see every allocation. */
+
+#if defined(_MSC_VER)
+#define POOL_THREAD_LOCAL  __declspec(thread)
+#elif defined(__GNUC__)
+#define POOL_THREAD_LOCAL  __thread
+#endif
+
+#define POOL_GRANULE   16
+#define POOL_CLASSES   8
+#define POOL_MAX_FREE  256
+
+#ifdef POOL_THREAD_LOCAL
+
+struct pool_block {
+    struct pool_block *next;
+};
+
+struct pool_class {
+    struct pool_block *free;
+    size_t count;
+};
+
+static POOL_THREAD_LOCAL struct pool_class pool[POOL_CLASSES];
+static int pool_enabled = 1;
+
+void *jsonp_pool_malloc(size_t size)
+{
+    struct pool_class *class_;
+    struct pool_block *block;
+
+    if(!size || size > POOL_CLASSES * POOL_GRANULE)
+        return jsonp_malloc(size);
+
+    class_ = &pool[(size - 1) / POOL_GRANULE];
+    block = pool_enabled ? class_->free : NULL;
+    if(!block) {
+        /* Allocate the full class size so the block fits any size of
+           its class when it's reused, even if the pool is only enabled
+           by the time it's freed */
+        return (*do_malloc)(((size - 1) / POOL_GRANULE + 1) * POOL_GRANULE);
+    }
+
+    class_->free = block->next;
+    class_->count--;
+    return block;
+}
+
+void jsonp_pool_free(void *ptr, size_t size)
+{
+    struct pool_class *class_;
+    struct pool_block *block = ptr;
+
+    if(!pool_enabled || !ptr || size > POOL_CLASSES * POOL_GRANULE) {
+        jsonp_free(ptr);
+        return;
+    }
+
+    class_ = &pool[(size - 1) / POOL_GRANULE];
+    if(class_->count >= POOL_MAX_FREE) {
+        (*do_free)(ptr);
+        return;
+    }
+
+    block->next = class_->free;
+    class_->free = block;
+    class_->count++;
+}
+
+void json_pool_flush(void)
+{
+    struct pool_block *block, *next;
+    size_t i;
+
+    for(i = 0; i < POOL_CLASSES; i++) {
+        for(block = pool[i].free; block; block = next) {
+            next = block->next;
+            (*do_free)(block);
+        }
+        pool[i].free = NULL;
+        pool[i].count = 0;
+    }
+}
+
+#else
+
+void *jsonp_pool_malloc(size_t size)
+{
+    return jsonp_malloc(size);
+}
+
+void jsonp_pool_free(void *ptr, size_t size)
+{
+    (void)size;
+    jsonp_free(ptr);
+}
+
+void json_pool_flush(void)
+{
+}
+
+#endif
+
+/* arena */
+
+/* Blocks are chained newest first, their memory follows the header */
+struct arena_block {
+    struct arena_block *next;
+    char *end;
+};
+
+struct jsonp_arena {
+    size_t refcount;
+    int closed;
+    size_t block_size;
+    struct arena_block *blocks;
+    char *next;
+    char *end;
+};
+
+#define ARENA_MIN_BLOCK     4096
+#define ARENA_ALIGN(size_)  (((size_) + 7) & ~(size_t)7)
+#define ARENA_HEADER        ARENA_ALIGN(sizeof(struct arena_block))
+
+jsonp_arena_t *jsonp_arena_new(void)
+{
+    jsonp_arena_t *arena = jsonp_malloc(sizeof(jsonp_arena_t));
+    if(!arena)
+        return NULL;
+
+    arena->refcount = 1;
+    arena->closed = 0;
+    arena->block_size = ARENA_MIN_BLOCK;
+    arena->blocks = NULL;
+    arena->next = arena->end = NULL;
+    return arena;
+}
+
+static int arena_grow(jsonp_arena_t *arena, size_t size)
+{
+    struct arena_block *block;
+    size_t block_size = max(arena->block_size, ARENA_HEADER + size);
+
+    block = jsonp_malloc(block_size);
+    if(!block)
+        return -1;
+
+    block->next = arena->blocks;
+    block->end = (char *)block + block_size;
+    arena->blocks = block;
+    arena->next = (char *)block + ARENA_HEADER;
+    arena->end = block->end;
+
+    /* Double the blocks so that even big documents only need a few */
+    arena->block_size = block_size * 2;
+    return 0;
+}
+
+static int arena_owns(const jsonp_arena_t *arena, const void *ptr)
+{
+    const struct arena_block *block;
+
+    for(block = arena->blocks; block; block = block->next) {
+        if((const char *)ptr >= (const char *)block + ARENA_HEADER &&
+           (const char *)ptr < block->end)
+            return 1;
+    }
+    return 0;
+}
+
+static void *arena_alloc(jsonp_arena_t *arena, size_t size)
+{
+    char *result;
+
+    if(!size)
+        return NULL;
+
+    size = ARENA_ALIGN(size);
+    if((size_t)(arena->end - arena->next) < size && arena_grow(arena, size))
+        return NULL;
+
+    result = arena->next;
+    arena->next += size;
+    return result;
+}
+
+void *jsonp_arena_malloc(jsonp_arena_t *arena, size_t size)
+{
+    if(!arena || arena->closed)
+        return jsonp_malloc(size);
+
+    return arena_alloc(arena, size);
+}
+
+void jsonp_arena_free(jsonp_arena_t *arena, void *ptr)
+{
+    /* Arena memory is only released with the whole arena */
+    if(arena && arena_owns(arena, ptr))
+        return;
+
+    jsonp_free(ptr);
+}
+
+void *jsonp_arena_pool_malloc(jsonp_arena_t *arena, size_t size)
+{
+    if(!arena || arena->closed)
+        return jsonp_pool_malloc(size);
+
+    return arena_alloc(arena, size);
+}
+
+void jsonp_arena_pool_free(jsonp_arena_t *arena, void *ptr, size_t size)
+{
+    if(arena && arena_owns(arena, ptr))
+        return;
+
+    jsonp_pool_free(ptr, size);
+}
+
+char *jsonp_arena_strndup(jsonp_arena_t *arena, const char *str, size_t len)
+{
+    char *new_str;
+
+    if(len == (size_t)-1)
+        return NULL;
+
+    new_str = jsonp_arena_malloc(arena, len + 1);
+    if(!new_str)
+        return NULL;
+
+    memcpy(new_str, str, len);
+    new_str[len] = '\0';
+    return new_str;
+}
+
+jsonp_arena_t *jsonp_arena_incref(jsonp_arena_t *arena)
+{
+    if(arena)
+        arena->refcount++;
+    return arena;
+}
+
+void jsonp_arena_decref(jsonp_arena_t *arena)
+{
+    struct arena_block *block, *next;
+
+    if(!arena || --arena->refcount != 0)
+        return;
+
+    for(block = arena->blocks; block; block = next) {
+        next = block->next;
+        jsonp_free(block);
+    }
+    jsonp_free(arena);
+}
+
+void jsonp_arena_close(jsonp_arena_t *arena)
+{
+    if(!arena)
+        return;
+
+    arena->closed = 1;
+    jsonp_arena_decref(arena);
+}
+
 void json_set_alloc_funcs(json_malloc_t malloc_fn, json_free_t free_fn)
 {
+    /* The cached blocks belong to the old functions. Only the calling
+       thread's cache can be flushed here, which is why no other thread
+       may hold values or cached blocks at this point. */
+    json_pool_flush();
+
     do_malloc = malloc_fn;
     do_free = free_fn;
+#ifdef POOL_THREAD_LOCAL
+    pool_enabled = (malloc_fn == malloc && free_fn == free);
+#endif
 }
@@ -33,6 +33,13 @@ typedef struct {
 
 #define token(scanner) ((scanner)->token.token)
 
+/* Where the arguments come from: either a va_list or a callback */
+typedef struct {
+    va_list *ap;
+    json_arg_callback_t callback;
+    void *data;
+} args_t;
+
 static const char * const type_names[] = {
     "object",
     "array",
@@ -119,12 +126,117 @@ static void set_error(scanner_t *s, const char *source, const char *fmt, ...)
     va_end(ap);
 }
 
-static json_t *pack(scanner_t *s, va_list *ap);
+/* Fetch the next argument for the format character type. Returns -1
+   and sets an error if the callback can't provide it. */
+static int next_arg(scanner_t *s, args_t *args, char type, json_arg_t *arg)
+{
+    if(args->callback(type, arg, args->data)) {
+        set_error(s, "<args>", "Missing or invalid argument for '%c'", type);
+        return -1;
+    }
+    return 0;
+}
+
+static int arg_string(scanner_t *s, args_t *args, char type, const char **str)
+{
+    json_arg_t arg;
+
+    if(args->ap) {
+        *str = va_arg(*args->ap, const char *);
+        return 0;
+    }
+
+    if(next_arg(s, args, type, &arg))
+        return -1;
+    *str = arg.string;
+    return 0;
+}
+
+static int arg_int(scanner_t *s, args_t *args, char type, int *value)
+{
+    json_arg_t arg;
+
+    if(args->ap) {
+        *value = va_arg(*args->ap, int);
+        return 0;
+    }
+
+    if(next_arg(s, args, type, &arg))
+        return -1;
+    *value = arg.integer;
+    return 0;
+}
+
+static int arg_json_int(scanner_t *s, args_t *args, json_int_t *value)
+{
+    json_arg_t arg;
+
+    if(args->ap) {
+        *value = va_arg(*args->ap, json_int_t);
+        return 0;
+    }
+
+    if(next_arg(s, args, 'I', &arg))
+        return -1;
+    *value = arg.json_int;
+    return 0;
+}
+
+static int arg_real(scanner_t *s, args_t *args, double *value)
+{
+    json_arg_t arg;
+
+    if(args->ap) {
+        *value = va_arg(*args->ap, double);
+        return 0;
+    }
+
+    if(next_arg(s, args, 'f', &arg))
+        return -1;
+    *value = arg.real;
+    return 0;
+}
+
+static int arg_json(scanner_t *s, args_t *args, char type, json_t **json)
+{
+    json_arg_t arg;
+
+    if(args->ap) {
+        *json = va_arg(*args->ap, json_t *);
+        return 0;
+    }
+
+    if(next_arg(s, args, type, &arg))
+        return -1;
+    *json = arg.json;
+    return 0;
+}
+
+/* Unpacking targets are always pointers */
+static void *arg_target(scanner_t *s, args_t *args, char type)
+{
+    json_arg_t arg;
+    void *target;
+
+    if(args->ap) {
+        target = va_arg(*args->ap, void *);
+        if(!target)
+            set_error(s, "<args>", "NULL %s argument",
+                      type == 's' ? "string" : "target");
+        return target;
+    }
+
+    if(next_arg(s, args, type, &arg))
+        return NULL;
+    return arg.target;
+}
+
+static json_t *pack(scanner_t *s, args_t *ap);
 
 
 /* ours will be set to 1 if jsonp_free() must be called for the result
    afterwards */
-static char *read_string(scanner_t *s, va_list *ap,
+static char *read_string(scanner_t *s, args_t *ap,
                          const char *purpose, int *ours)
 {
     char t;
@@ -139,7 +251,8 @@ static char *read_string(scanner_t *s, va_list *ap,
 
     if(t != '#' && t != '+') {
         /* Optimize the simple case */
-        str = va_arg(*ap, const char *);
+        if(arg_string(s, ap, 's', &str))
+            return NULL;
 
         if(!str) {
             set_error(s, "<args>", "NULL string argument");
@@ -158,7 +271,10 @@ static char *read_string(scanner_t *s, va_list *ap,
     strbuffer_init(&strbuff);
 
     while(1) {
-        str = va_arg(*ap, const char *);
+        if(arg_string(s, ap, 's', &str)) {
+            strbuffer_close(&strbuff);
+            return NULL;
+        }
         if(!str) {
             set_error(s, "<args>", "NULL string argument");
             strbuffer_close(&strbuff);
@@ -168,7 +284,12 @@ static char *read_string(scanner_t *s, va_list *ap,
         next_token(s);
 
         if(token(s) == '#') {
-            length = va_arg(*ap, int);
+            int value;
+            if(arg_int(s, ap, '#', &value)) {
+                strbuffer_close(&strbuff);
+                return NULL;
+            }
+            length = value;
         }
         else {
             prev_token(s);
@@ -199,7 +320,7 @@ static char *read_string(scanner_t *s, va_list *ap,
     return result;
 }
 
-static json_t *pack_object(scanner_t *s, va_list *ap)
+static json_t *pack_object(scanner_t *s, args_t *ap)
 {
     json_t *object = json_object();
     next_token(s);
@@ -250,7 +371,7 @@ error:
     return NULL;
 }
 
-static json_t *pack_array(scanner_t *s, va_list *ap)
+static json_t *pack_array(scanner_t *s, args_t *ap)
 {
     json_t *array = json_array();
     next_token(s);
@@ -281,8 +402,13 @@ error:
     return NULL;
 }
 
-static json_t *pack(scanner_t *s, va_list *ap)
+static json_t *pack(scanner_t *s, args_t *ap)
 {
+    int value;
+    json_int_t json_int;
+    double real;
+    json_t *json;
+
     switch(token(s)) {
         case '{':
             return pack_object(s, ap);
@@ -310,22 +436,34 @@ static json_t *pack(scanner_t *s, va_list *ap)
             return json_null();
 
         case 'b': /* boolean */
-            return va_arg(*ap, int) ? json_true() : json_false();
+            if(arg_int(s, ap, 'b', &value))
+                return NULL;
+            return value ? json_true() : json_false();
 
         case 'i': /* integer from int */
-            return json_integer(va_arg(*ap, int));
+            if(arg_int(s, ap, 'i', &value))
+                return NULL;
+            return json_integer(value);
 
         case 'I': /* integer from json_int_t */
-            return json_integer(va_arg(*ap, json_int_t));
+            if(arg_json_int(s, ap, &json_int))
+                return NULL;
+            return json_integer(json_int);
 
         case 'f': /* real */
-            return json_real(va_arg(*ap, double));
+            if(arg_real(s, ap, &real))
+                return NULL;
+            return json_real(real);
 
         case 'O': /* a json_t object; increments refcount */
-            return json_incref(va_arg(*ap, json_t *));
+            if(arg_json(s, ap, 'O', &json))
+                return NULL;
+            return json_incref(json);
 
         case 'o': /* a json_t object; doesn't increment refcount */
-            return va_arg(*ap, json_t *);
+            if(arg_json(s, ap, 'o', &json))
+                return NULL;
+            return json;
 
         default:
             set_error(s, "<format>", "Unexpected format character '%c'",
@@ -334,9 +472,9 @@ static json_t *pack(scanner_t *s, va_list *ap)
     }
 }
 
-static int unpack(scanner_t *s, json_t *root, va_list *ap);
+static int unpack(scanner_t *s, json_t *root, args_t *ap);
 
-static int unpack_object(scanner_t *s, json_t *root, va_list *ap)
+static int unpack_object(scanner_t *s, json_t *root, args_t *ap)
 {
     int ret = -1;
     int strict = 0;
@@ -348,7 +486,7 @@ static int unpack_object(scanner_t *s, json_t *root, va_list *ap)
     */
     hashtable_t key_set;
 
-    if(hashtable_init(&key_set)) {
+    if(hashtable_init(&key_set, NULL)) {
         set_error(s, "<internal>", "Out of memory");
         return -1;
     }
@@ -387,7 +525,8 @@ static int unpack_object(scanner_t *s, json_t *root, va_list *ap)
             goto out;
         }
 
-        key = va_arg(*ap, const char *);
+        if(arg_string(s, ap, 'k', &key))
+            goto out;
         if(!key) {
             set_error(s, "<args>", "NULL object key");
             goto out;
@@ -415,7 +554,7 @@ static int unpack_object(scanner_t *s, json_t *root, va_list *ap)
         if(unpack(s, value, ap))
             goto out;
 
-        hashtable_set(&key_set, key, 0, json_null());
+        hashtable_set(&key_set, key, json_null());
         next_token(s);
     }
 
@@ -435,7 +574,7 @@ out:
     return ret;
 }
 
-static int unpack_array(scanner_t *s, json_t *root, va_list *ap)
+static int unpack_array(scanner_t *s, json_t *root, args_t *ap)
 {
     size_t i = 0;
     int strict = 0;
@@ -505,7 +644,7 @@ static int unpack_array(scanner_t *s, json_t *root, va_list *ap)
     return 0;
 }
 
-static int unpack(scanner_t *s, json_t *root, va_list *ap)
+static int unpack(scanner_t *s, json_t *root, args_t *ap)
 {
     switch(token(s))
     {
@@ -525,11 +664,9 @@ static int unpack(scanner_t *s, json_t *root, va_list *ap)
             if(!(s->flags & JSON_VALIDATE_ONLY)) {
                 const char **target;
 
-                target = va_arg(*ap, const char **);
-                if(!target) {
-                    set_error(s, "<args>", "NULL string argument");
+                target = arg_target(s, ap, 's');
+                if(!target)
                     return -1;
-                }
 
                 if(root)
                     *target = json_string_value(root);
@@ -544,7 +681,9 @@ static int unpack(scanner_t *s, json_t *root, va_list *ap)
             }
 
             if(!(s->flags & JSON_VALIDATE_ONLY)) {
-                int *target = va_arg(*ap, int*);
+                int *target = arg_target(s, ap, 'i');
+                if(!target)
+                    return -1;
                 if(root)
                     *target = (int)json_integer_value(root);
             }
@@ -559,7 +698,9 @@ static int unpack(scanner_t *s, json_t *root, va_list *ap)
             }
 
             if(!(s->flags & JSON_VALIDATE_ONLY)) {
-                json_int_t *target = va_arg(*ap, json_int_t*);
+                json_int_t *target = arg_target(s, ap, 'I');
+                if(!target)
+                    return -1;
                 if(root)
                     *target = json_integer_value(root);
             }
@@ -574,7 +715,9 @@ static int unpack(scanner_t *s, json_t *root, va_list *ap)
             }
 
             if(!(s->flags & JSON_VALIDATE_ONLY)) {
-                int *target = va_arg(*ap, int*);
+                int *target = arg_target(s, ap, 'b');
+                if(!target)
+                    return -1;
                 if(root)
                     *target = json_is_true(root);
             }
@@ -589,7 +732,9 @@ static int unpack(scanner_t *s, json_t *root, va_list *ap)
             }
 
             if(!(s->flags & JSON_VALIDATE_ONLY)) {
-                double *target = va_arg(*ap, double*);
+                double *target = arg_target(s, ap, 'f');
+                if(!target)
+                    return -1;
                 if(root)
                     *target = json_real_value(root);
             }
@@ -604,7 +749,9 @@ static int unpack(scanner_t *s, json_t *root, va_list *ap)
             }
 
             if(!(s->flags & JSON_VALIDATE_ONLY)) {
-                double *target = va_arg(*ap, double*);
+                double *target = arg_target(s, ap, 'F');
+                if(!target)
+                    return -1;
                 if(root)
                     *target = json_number_value(root);
             }
@@ -612,15 +759,16 @@ static int unpack(scanner_t *s, json_t *root, va_list *ap)
             return 0;
 
         case 'O':
-            if(root && !(s->flags & JSON_VALIDATE_ONLY))
-                json_incref(root);
-            /* Fall through */
-
         case 'o':
             if(!(s->flags & JSON_VALIDATE_ONLY)) {
-                json_t **target = va_arg(*ap, json_t**);
-                if(root)
+                json_t **target = arg_target(s, ap, token(s));
+                if(!target)
+                    return -1;
+                if(root) {
+                    if(token(s) == 'O')
+                        json_incref(root);
                     *target = root;
+                }
             }
 
             return 0;
@@ -641,11 +789,10 @@ static int unpack(scanner_t *s, json_t *root, va_list *ap)
     }
 }
 
-json_t *json_vpack_ex(json_error_t *error, size_t flags,
-                      const char *fmt, va_list ap)
+static json_t *do_pack(json_error_t *error, size_t flags,
+                       const char *fmt, args_t *args)
 {
     scanner_t s;
-    va_list ap_copy;
     json_t *value;
 
     if(!fmt || !*fmt) {
@@ -658,10 +805,7 @@ json_t *json_vpack_ex(json_error_t *error, size_t flags,
     scanner_init(&s, error, flags, fmt);
     next_token(&s);
 
-    va_copy(ap_copy, ap);
-    value = pack(&s, &ap_copy);
-    va_end(ap_copy);
-
+    value = pack(&s, args);
     if(!value)
         return NULL;
 
@@ -675,6 +819,23 @@ json_t *json_vpack_ex(json_error_t *error, size_t flags,
     return value;
 }
 
+json_t *json_vpack_ex(json_error_t *error, size_t flags,
+                      const char *fmt, va_list ap)
+{
+    args_t args;
+    va_list ap_copy;
+    json_t *value;
+
+    va_copy(ap_copy, ap);
+    args.ap = &ap_copy;
+    args.callback = NULL;
+    args.data = NULL;
+    value = do_pack(error, flags, fmt, &args);
+    va_end(ap_copy);
+
+    return value;
+}
+
 json_t *json_pack_ex(json_error_t *error, size_t flags, const char *fmt, ...)
 {
     json_t *value;
@@ -699,11 +860,27 @@ json_t *json_pack(const char *fmt, ...)
     return value;
 }
 
-int json_vunpack_ex(json_t *root, json_error_t *error, size_t flags,
-                    const char *fmt, va_list ap)
+json_t *json_pack_callback(json_error_t *error, size_t flags, const char *fmt,
+                           json_arg_callback_t callback, void *data)
+{
+    args_t args;
+
+    if(!callback) {
+        jsonp_error_init(error, "<args>");
+        jsonp_error_set(error, -1, -1, 0, "NULL argument callback");
+        return NULL;
+    }
+
+    args.ap = NULL;
+    args.callback = callback;
+    args.data = data;
+    return do_pack(error, flags, fmt, &args);
+}
+
+static int do_unpack(json_t *root, json_error_t *error, size_t flags,
+                     const char *fmt, args_t *args)
 {
     scanner_t s;
-    va_list ap_copy;
 
     if(!root) {
         jsonp_error_init(error, "<root>");
@@ -721,12 +898,8 @@ int json_vunpack_ex(json_t *root, json_error_t *error, size_t flags,
     scanner_init(&s, error, flags, fmt);
     next_token(&s);
 
-    va_copy(ap_copy, ap);
-    if(unpack(&s, root, &ap_copy)) {
-        va_end(ap_copy);
+    if(unpack(&s, root, args))
         return -1;
-    }
-    va_end(ap_copy);
 
     next_token(&s);
     if(token(&s)) {
@@ -737,6 +910,23 @@ int json_vunpack_ex(json_t *root, json_error_t *error, size_t flags,
     return 0;
 }
 
+int json_vunpack_ex(json_t *root, json_error_t *error, size_t flags,
+                    const char *fmt, va_list ap)
+{
+    args_t args;
+    va_list ap_copy;
+    int ret;
+
+    va_copy(ap_copy, ap);
+    args.ap = &ap_copy;
+    args.callback = NULL;
+    args.data = NULL;
+    ret = do_unpack(root, error, flags, fmt, &args);
+    va_end(ap_copy);
+
+    return ret;
+}
+
 int json_unpack_ex(json_t *root, json_error_t *error, size_t flags, const char *fmt, ...)
 {
     int ret;
@@ -760,3 +950,21 @@ int json_unpack(json_t *root, const char *fmt, ...)
 
     return ret;
 }
+
+int json_unpack_callback(json_t *root, json_error_t *error, size_t flags,
+                         const char *fmt, json_arg_callback_t callback,
+                         void *data)
+{
+    args_t args;
+
+    if(!callback) {
+        jsonp_error_init(error, "<args>");
+        jsonp_error_set(error, -1, -1, 0, "NULL argument callback");
+        return -1;
+    }
+
+    args.ap = NULL;
+    args.callback = callback;
+    args.data = data;
+    return do_unpack(root, error, flags, fmt, &args);
+}
@@ -1,7 +1,9 @@
 #include <assert.h>
 #include <errno.h>
+#include <float.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include "jansson_private.h"
 #include "strbuffer.h"
 
@@ -18,9 +20,9 @@
     character.
 
   - If setlocale() is called by another thread between the call to
-    localeconv() and the call to sprintf() or strtod(), the result may
-    be wrong. setlocale() is not thread-safe and should not be used
-    this way. Multi-threaded programs should use uselocale() instead.
+    localeconv() and the call to strtod(), the result may be wrong.
+    setlocale() is not thread-safe and should not be used this way.
+    Multi-threaded programs should use uselocale() instead.
 */
 
 static void to_locale(strbuffer_t *strbuffer)
@@ -38,21 +40,105 @@ static void to_locale(strbuffer_t *strbuffer)
     if(pos)
         *pos = *point;
 }
+#endif
+
+/* The fast paths below need doubles to be rounded to double precision
+   after every operation, which isn't the case with the x87 FPU */
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD == 0
+#define USE_FAST_STRTOD
+#endif
+
+#define DP_SIGNIFICAND_MASK  0x000FFFFFFFFFFFFFULL
+#define DP_EXPONENT_MASK     0x7FF0000000000000ULL
+#define DP_HIDDEN_BIT        0x0010000000000000ULL
+#define DP_SIGNIFICAND_SIZE  52
+#define DP_EXPONENT_BIAS     (0x3FF + DP_SIGNIFICAND_SIZE)
 
-static void from_locale(char *buffer)
+static uint64_t double_to_bits(double value)
 {
-    const char *point;
-    char *pos;
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
 
-    point = localeconv()->decimal_point;
-    if(*point == '.') {
-        /* No conversion needed */
-        return;
+
+/*** string -> double ***/
+
+#ifdef USE_FAST_STRTOD
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Clinger's fast path: if the decimal significand and the power of ten
+   are both exactly representable as doubles, a single multiplication or
+   division gives the correctly rounded result. The input has already
+   been validated by the lexer. Return -1 if the fast path doesn't
+   apply. */
+static int fast_strtod(const char *str, double *out)
+{
+    uint64_t significand = 0;
+    int digits = 0;
+    int exponent = 0;
+    int negative = 0;
+    double value;
+
+    if(*str == '-') {
+        negative = 1;
+        str++;
     }
 
-    pos = strchr(buffer, *point);
-    if(pos)
-        *pos = '.';
+    for(; '0' <= *str && *str <= '9'; str++) {
+        if(digits || *str != '0')
+            digits++;
+        significand = significand * 10 + (*str - '0');
+        if(digits > 15)
+            return -1;
+    }
+
+    if(*str == '.') {
+        for(str++; '0' <= *str && *str <= '9'; str++) {
+            if(digits || *str != '0')
+                digits++;
+            significand = significand * 10 + (*str - '0');
+            exponent--;
+            if(digits > 15)
+                return -1;
+        }
+    }
+
+    if(*str == 'e' || *str == 'E') {
+        int exp_negative = 0;
+        int value = 0;
+
+        str++;
+        if(*str == '+' || *str == '-')
+            exp_negative = (*str++ == '-');
+
+        for(; '0' <= *str && *str <= '9'; str++) {
+            value = value * 10 + (*str - '0');
+            if(value > 1000)
+                return -1;
+        }
+
+        exponent += exp_negative ? -value : value;
+    }
+
+    /* at most 15 digits always fit in the 53 bits of a double */
+    value = (double)significand;
+    if(significand == 0)
+        exponent = 0;
+
+    if(exponent < -22 || exponent > 22)
+        return -1;
+
+    if(exponent < 0)
+        value /= exact_powers_of_ten[-exponent];
+    else
+        value *= exact_powers_of_ten[exponent];
+
+    *out = negative ? -value : value;
+    return 0;
 }
 #endif
 
@@ -61,6 +147,11 @@ int jsonp_strtod(strbuffer_t *strbuffer, double *out)
     double value;
     char *end;
 
+#ifdef USE_FAST_STRTOD
+    if(fast_strtod(strbuffer->value, out) == 0)
+        return 0;
+#endif
+
 #if JSON_HAVE_LOCALECONV
     to_locale(strbuffer);
 #endif
@@ -78,57 +169,389 @@ int jsonp_strtod(strbuffer_t *strbuffer, double *out)
     return 0;
 }
 
+
+/*** double -> string ***/
+
+/*
+  The shortest digit string that reads back as the same double is found
+  with the Grisu2 algorithm from Florian Loitsch, "Printing
+  Floating-Point Numbers Quickly and Accurately with Integers" (PLDI
+  2010). The output always round-trips, and is the shortest possible in
+  all but very rare cases.
+*/
+
+typedef struct {
+    uint64_t f;
+    int e;
+} diy_fp_t;
+
+/* Normalized approximations of 10^-348, 10^-340, ..., 10^340 */
+static const uint64_t cached_powers_f[] = {
+    0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76,
+    0xcf42894a5dce35ea, 0x9a6bb0aa55653b2d, 0xe61acf033d1a45df,
+    0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f, 0xbe5691ef416bd60c,
+    0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+    0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57,
+    0xc21094364dfb5637, 0x9096ea6f3848984f, 0xd77485cb25823ac7,
+    0xa086cfcd97bf97f4, 0xef340a98172aace5, 0xb23867fb2a35b28e,
+    0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+    0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126,
+    0xb5b5ada8aaff80b8, 0x87625f056c7c4a8b, 0xc9bcff6034c13053,
+    0x964e858c91ba2655, 0xdff9772470297ebd, 0xa6dfbd9fb8e5b88f,
+    0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+    0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06,
+    0xaa242499697392d3, 0xfd87b5f28300ca0e, 0xbce5086492111aeb,
+    0x8cbccc096f5088cc, 0xd1b71758e219652c, 0x9c40000000000000,
+    0xe8d4a51000000000, 0xad78ebc5ac620000, 0x813f3978f8940984,
+    0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068,
+    0x9f4f2726179a2245, 0xed63a231d4c4fb27, 0xb0de65388cc8ada8,
+    0x83c7088e1aab65db, 0xc45d1df942711d9a, 0x924d692ca61be758,
+    0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85,
+    0xb454e4a179dd1877, 0x865b86925b9bc5c2, 0xc83553c5c8965d3d,
+    0x952ab45cfa97a0b3, 0xde469fbd99a05fe3, 0xa59bc234db398c25,
+    0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece, 0x88fcf317f22241e2,
+    0xcc20ce9bd35c78a5, 0x98165af37b2153df, 0xe2a0b5dc971f303a,
+    0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410,
+    0x8bab8eefb6409c1a, 0xd01fef10a657842c, 0x9b10a4e5e9913129,
+    0xe7109bfba19c0c9d, 0xac2820d9623bf429, 0x80444b5e7aa7cf85,
+    0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841,
+    0x9e19db92b4e31ba9, 0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b
+};
+
+static const int16_t cached_powers_e[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+};
+
+static diy_fp_t diy_fp_multiply(diy_fp_t x, diy_fp_t y)
+{
+    const uint64_t M32 = 0xFFFFFFFFULL;
+    uint64_t a = x.f >> 32, b = x.f & M32;
+    uint64_t c = y.f >> 32, d = y.f & M32;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+    diy_fp_t result;
+
+    /* round */
+    tmp += 1U << 31;
+
+    result.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+    result.e = x.e + y.e + 64;
+    return result;
+}
+
+static diy_fp_t diy_fp_normalize(diy_fp_t x)
+{
+    while(!(x.f & 0x8000000000000000ULL)) {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+/* Compute the boundaries m- and m+ of the interval of real numbers that
+   round to v, both with the exponent of the normalized m+ */
+static void normalized_boundaries(diy_fp_t v, diy_fp_t *minus, diy_fp_t *plus)
+{
+    diy_fp_t pl, mi;
+
+    pl.f = (v.f << 1) + 1;
+    pl.e = v.e - 1;
+    while(!(pl.f & (DP_HIDDEN_BIT << 1))) {
+        pl.f <<= 1;
+        pl.e--;
+    }
+    pl.f <<= 64 - DP_SIGNIFICAND_SIZE - 2;
+    pl.e -= 64 - DP_SIGNIFICAND_SIZE - 2;
+
+    /* the lower boundary is closer at powers of two */
+    if(v.f == DP_HIDDEN_BIT) {
+        mi.f = (v.f << 2) - 1;
+        mi.e = v.e - 2;
+    }
+    else {
+        mi.f = (v.f << 1) - 1;
+        mi.e = v.e - 1;
+    }
+    mi.f <<= mi.e - pl.e;
+    mi.e = pl.e;
+
+    *plus = pl;
+    *minus = mi;
+}
+
+/* Return a cached power of ten c such that multiplying a number with
+   binary exponent e by it gives an exponent in [-60, -32]. *k is set to
+   the negated decimal exponent of c. */
+static diy_fp_t cached_power(int e, int *k)
+{
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int ik = (int)dk;
+    unsigned int index;
+    diy_fp_t result;
+
+    if(dk - ik > 0.0)
+        ik++;
+
+    index = (unsigned int)((ik >> 3) + 1);
+    *k = -(-348 + (int)(index << 3));
+
+    result.f = cached_powers_f[index];
+    result.e = cached_powers_e[index];
+    return result;
+}
+
+static void grisu_round(char *buffer, int length, uint64_t delta,
+                        uint64_t rest, uint64_t ten_kappa, uint64_t wp_w)
+{
+    while(rest < wp_w && delta - rest >= ten_kappa &&
+          (rest + ten_kappa < wp_w ||
+           wp_w - rest > rest + ten_kappa - wp_w)) {
+        buffer[length - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static const uint64_t powers_of_ten[] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+    100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+    100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL,
+    10000000000000000000ULL
+};
+
+static int count_digits(uint32_t n)
+{
+    int count = 1;
+    while(count < 10 && n >= powers_of_ten[count])
+        count++;
+    return count;
+}
+
+static void digit_gen(diy_fp_t w, diy_fp_t mp, uint64_t delta,
+                      char *buffer, int *length, int *k)
+{
+    diy_fp_t one;
+    uint64_t wp_w = mp.f - w.f;
+    uint32_t p1;
+    uint64_t p2;
+    int kappa;
+
+    one.f = 1ULL << -mp.e;
+    one.e = mp.e;
+
+    p1 = (uint32_t)(mp.f >> -one.e);
+    p2 = mp.f & (one.f - 1);
+    kappa = count_digits(p1);
+    *length = 0;
+
+    /* integral part */
+    while(kappa > 0) {
+        uint32_t d = p1 / (uint32_t)powers_of_ten[kappa - 1];
+        uint64_t tmp;
+
+        p1 %= (uint32_t)powers_of_ten[kappa - 1];
+        if(d || *length)
+            buffer[(*length)++] = (char)('0' + d);
+        kappa--;
+
+        tmp = ((uint64_t)p1 << -one.e) + p2;
+        if(tmp <= delta) {
+            *k += kappa;
+            grisu_round(buffer, *length, delta, tmp,
+                        powers_of_ten[kappa] << -one.e, wp_w);
+            return;
+        }
+    }
+
+    /* fractional part */
+    while(1) {
+        char d;
+
+        p2 *= 10;
+        delta *= 10;
+        d = (char)(p2 >> -one.e);
+        if(d || *length)
+            buffer[(*length)++] = (char)('0' + d);
+        p2 &= one.f - 1;
+        kappa--;
+
+        if(p2 < delta) {
+            *k += kappa;
+            grisu_round(buffer, *length, delta, p2, one.f,
+                        -kappa < 20 ? wp_w * powers_of_ten[-kappa] : 0);
+            return;
+        }
+    }
+}
+
+/* Write the shortest digits of the positive, finite value to buffer.
+   value == digits * 10^k */
+static int grisu2(double value, char *buffer, int *k)
+{
+    uint64_t bits = double_to_bits(value);
+    int biased_e = (int)((bits & DP_EXPONENT_MASK) >> DP_SIGNIFICAND_SIZE);
+    diy_fp_t v, w_m, w_p, c_mk, w;
+    int length;
+
+    v.f = bits & DP_SIGNIFICAND_MASK;
+    if(biased_e != 0) {
+        v.f += DP_HIDDEN_BIT;
+        v.e = biased_e - DP_EXPONENT_BIAS;
+    }
+    else
+        v.e = 1 - DP_EXPONENT_BIAS;
+
+    normalized_boundaries(v, &w_m, &w_p);
+    c_mk = cached_power(w_p.e, k);
+    w = diy_fp_multiply(diy_fp_normalize(v), c_mk);
+    w_p = diy_fp_multiply(w_p, c_mk);
+    w_m = diy_fp_multiply(w_m, c_mk);
+    w_m.f++;
+    w_p.f--;
+
+    digit_gen(w, w_p, w_p.f - w_m.f, buffer, &length, k);
+    return length;
+}
+
 int jsonp_dtostr(char *buffer, size_t size, double value)
 {
-    int ret;
-    char *start, *end;
-    size_t length;
+    char digits[20];
+    char *out = buffer;
+    int length, k, point;
 
-    ret = snprintf(buffer, size, "%.17g", value);
-    if(ret < 0)
-        return -1;
+    if((double_to_bits(value) & DP_EXPONENT_MASK) == DP_EXPONENT_MASK) {
+        /* inf and nan have no JSON representation */
+        int ret = snprintf(buffer, size, "%g", value);
+        if(ret < 0 || (size_t)ret >= size)
+            return -1;
+        return ret;
+    }
 
-    length = (size_t)ret;
-    if(length >= size)
+    /* Worst case is "-0.000" followed by 17 digits, or a sign, 17
+       digits, a dot and "e-324" */
+    if(size < 32)
         return -1;
 
-#if JSON_HAVE_LOCALECONV
-    from_locale(buffer);
-#endif
+    if(double_to_bits(value) >> 63) {
+        *out++ = '-';
+        value = -value;
+    }
 
-    /* Make sure there's a dot or 'e' in the output. Otherwise
-       a real is converted to an integer when decoding */
-    if(strchr(buffer, '.') == NULL &&
-       strchr(buffer, 'e') == NULL)
-    {
-        if(length + 3 >= size) {
-            /* No space to append ".0" */
-            return -1;
+    if(value == 0) {
+        memcpy(out, "0.0", 4);
+        return (int)(out - buffer) + 3;
+    }
+
+    length = grisu2(value, digits, &k);
+
+    /* position of the decimal point relative to the first digit; the
+       same formats as printf("%.17g") are used, with a dot or an 'e'
+       always in the output so the value is read back as a real */
+    point = length + k;
+
+    if(0 < point && point <= 17) {
+        if(length <= point) {
+            /* 1234e7 -> 12340000000.0 */
+            memcpy(out, digits, length);
+            memset(out + length, '0', point - length);
+            out += point;
+            memcpy(out, ".0", 2);
+            out += 2;
         }
-        buffer[length] = '.';
-        buffer[length + 1] = '0';
-        buffer[length + 2] = '\0';
-        length += 2;
+        else {
+            /* 1234e-2 -> 12.34 */
+            memcpy(out, digits, point);
+            out[point] = '.';
+            memcpy(out + point + 1, digits + point, length - point);
+            out += length + 1;
+        }
+    }
+    else if(-4 < point && point <= 0) {
+        /* 1234e-6 -> 0.001234 */
+        out[0] = '0';
+        out[1] = '.';
+        memset(out + 2, '0', -point);
+        memcpy(out + 2 - point, digits, length);
+        out += 2 - point + length;
+    }
+    else {
+        /* 1234e30 -> 1.234e33 */
+        *out++ = digits[0];
+        if(length > 1) {
+            *out++ = '.';
+            memcpy(out, digits + 1, length - 1);
+            out += length - 1;
+        }
+        out += sprintf(out, "e%d", point - 1);
     }
 
-    /* Remove leading '+' from positive exponent. Also remove leading
-       zeros from exponents (added by some printf() implementations) */
-    start = strchr(buffer, 'e');
-    if(start) {
-        start++;
-        end = start + 1;
+    *out = '\0';
+    return (int)(out - buffer);
+}
 
-        if(*start == '-')
-            start++;
 
-        while(*end == '0')
-            end++;
+/*** integer -> string ***/
 
-        if(end != start) {
-            memmove(start, end, length - (size_t)(end - buffer));
-            length -= (size_t)(end - start);
-        }
+static const char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+int jsonp_itostr(char *buffer, size_t size, json_int_t value)
+{
+    /* enough for the 20 digits and sign of a 64-bit integer */
+    char digits[24];
+    char *pos = digits + sizeof(digits);
+    unsigned long long magnitude;
+    int length;
+
+    if(value < 0)
+        magnitude = 0ULL - (unsigned long long)value;
+    else
+        magnitude = (unsigned long long)value;
+
+    /* two digits per division, from the back */
+    while(magnitude >= 100) {
+        unsigned int pair = (unsigned int)(magnitude % 100) * 2;
+        magnitude /= 100;
+        pos -= 2;
+        pos[0] = digit_pairs[pair];
+        pos[1] = digit_pairs[pair + 1];
+    }
+
+    if(magnitude >= 10) {
+        unsigned int pair = (unsigned int)magnitude * 2;
+        pos -= 2;
+        pos[0] = digit_pairs[pair];
+        pos[1] = digit_pairs[pair + 1];
     }
+    else
+        *--pos = (char)('0' + magnitude);
+
+    if(value < 0)
+        *--pos = '-';
+
+    length = (int)(digits + sizeof(digits) - pos);
+    if((size_t)length >= size)
+        return -1;
 
-    return (int)length;
+    memcpy(buffer, pos, length);
+    buffer[length] = '\0';
+    return length;
 }
@@ -8,6 +8,16 @@
 #include <string.h>
 #include "utf.h"
 
+/* SSE2 is part of every x86-64 CPU, on 32-bit x86 it's only used if the
+   compiler was told it may */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UTF_USE_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 int utf8_encode(int32_t codepoint, char *buffer, int *size)
 {
     if(codepoint < 0)
@@ -188,3 +198,57 @@ int utf8_check_string(const char *string, int length)
 
     return 1;
 }
+
+#ifdef UTF_USE_SSE2
+static int lowest_bit(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (int)index;
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+#endif
+
+/* A plain byte is printable ASCII that can be copied into or out of a
+   JSON string as is */
+#define utf8_is_plain(c) \
+    (0x20 <= (unsigned char)(c) && (unsigned char)(c) < 0x80 && \
+     (c) != '"' && (c) != '\\')
+
+size_t utf8_plain_length(const char *buffer, size_t size)
+{
+    const char *p = buffer;
+    const char *end = buffer + size;
+
+#ifdef UTF_USE_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+
+    while(end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)p);
+
+        /* As signed bytes, both control characters and bytes of
+           multi-byte sequences compare less than a space */
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                         _mm_cmpeq_epi8(chunk, backslash)),
+            _mm_cmplt_epi8(chunk, space));
+
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(special);
+        if(mask)
+            return (p - buffer) + lowest_bit(mask);
+
+        p += 16;
+    }
+#endif
+
+    while(p < end && utf8_is_plain(*p))
+        p++;
+
+    return p - buffer;
+}
@@ -16,6 +16,8 @@
 #include <stdint.h>
 #endif
 
+#include <stddef.h>
+
 int utf8_encode(int codepoint, char *buffer, int *size);
 
 int utf8_check_first(char byte);
@@ -24,4 +26,9 @@ const char *utf8_iterate(const char *buffer, int32_t *codepoint);
 
 int utf8_check_string(const char *string, int length);
 
+/* Return the number of bytes at the start of buffer that are printable
+   ASCII and neither '"' nor '\\', i.e. need no escaping in a JSON
+   string */
+size_t utf8_plain_length(const char *buffer, size_t size);
+
 #endif
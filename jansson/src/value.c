@@ -46,9 +46,9 @@ static JSON_INLINE void json_init(json_t *json, json_type type)
 
 extern volatile uint32_t hashtable_seed;
 
-json_t *json_object(void)
+json_t *jsonp_object(jsonp_arena_t *arena)
 {
-    json_object_t *object = jsonp_malloc(sizeof(json_object_t));
+    json_object_t *object = jsonp_arena_pool_malloc(arena, sizeof(json_object_t));
     if(!object)
         return NULL;
 
@@ -59,22 +59,28 @@ json_t *json_object(void)
 
     json_init(&object->json, JSON_OBJECT);
 
-    if(hashtable_init(&object->hashtable))
+    if(hashtable_init(&object->hashtable, arena))
     {
-        jsonp_free(object);
+        jsonp_arena_pool_free(arena, object, sizeof(json_object_t));
         return NULL;
     }
 
-    object->serial = 0;
-    object->visited = 0;
-
+    jsonp_arena_incref(arena);
     return &object->json;
 }
 
+json_t *json_object(void)
+{
+    return jsonp_object(NULL);
+}
+
 static void json_delete_object(json_object_t *object)
 {
+    jsonp_arena_t *arena = object->hashtable.arena;
+
     hashtable_close(&object->hashtable);
-    jsonp_free(object);
+    jsonp_arena_pool_free(arena, object, sizeof(json_object_t));
+    jsonp_arena_decref(arena);
 }
 
 size_t json_object_size(const json_t *json)
@@ -88,6 +94,17 @@ size_t json_object_size(const json_t *json)
     return object->hashtable.size;
 }
 
+size_t json_object_revision(const json_t *json)
+{
+    json_object_t *object;
+
+    if(!json_is_object(json))
+        return 0;
+
+    object = json_to_object(json);
+    return object->hashtable.revision;
+}
+
 json_t *json_object_get(const json_t *json, const char *key)
 {
     json_object_t *object;
@@ -113,7 +130,7 @@ int json_object_set_new_nocheck(json_t *json, const char *key, json_t *value)
     }
     object = json_to_object(json);
 
-    if(hashtable_set(&object->hashtable, key, object->serial++, value))
+    if(hashtable_set(&object->hashtable, key, value))
     {
         json_decref(value);
         return -1;
@@ -154,7 +171,6 @@ int json_object_clear(json_t *json)
     object = json_to_object(json);
 
     hashtable_clear(&object->hashtable);
-    object->serial = 0;
 
     return 0;
 }
@@ -334,11 +350,107 @@ static json_t *json_object_deep_copy(const json_t *object)
 }
 
 
+/*** key ***/
+
+struct json_key_t {
+    size_t len;
+    size_t hash;
+    char key[1];
+};
+
+json_key_t *json_key(const char *key)
+{
+    json_key_t *result;
+    size_t len;
+
+    if(!key || !utf8_check_string(key, -1))
+        return NULL;
+
+    /* The seed is only ever set once, so the hash stays valid for all
+       objects created after this */
+    if (!hashtable_seed) {
+        /* Autoseed */
+        json_object_seed(0);
+    }
+
+    len = strlen(key);
+    result = jsonp_malloc(offsetof(json_key_t, key) + len + 1);
+    if(!result)
+        return NULL;
+
+    result->len = len;
+    result->hash = hashtable_hash(key, len);
+    memcpy(result->key, key, len + 1);
+
+    return result;
+}
+
+void json_key_free(json_key_t *key)
+{
+    jsonp_free(key);
+}
+
+const char *json_key_string(const json_key_t *key)
+{
+    if(!key)
+        return NULL;
+
+    return key->key;
+}
+
+json_t *json_object_get_key(const json_t *json, const json_key_t *key)
+{
+    json_object_t *object;
+
+    if(!key || !json_is_object(json))
+        return NULL;
+
+    object = json_to_object(json);
+    return hashtable_get_hashed(&object->hashtable, key->key,
+                                key->len, key->hash);
+}
+
+int json_object_set_new_key(json_t *json, const json_key_t *key, json_t *value)
+{
+    json_object_t *object;
+
+    if(!value)
+        return -1;
+
+    if(!key || !json_is_object(json) || json == value)
+    {
+        json_decref(value);
+        return -1;
+    }
+    object = json_to_object(json);
+
+    if(hashtable_set_hashed(&object->hashtable, key->key,
+                            key->len, key->hash, value))
+    {
+        json_decref(value);
+        return -1;
+    }
+
+    return 0;
+}
+
+int json_object_del_key(json_t *json, const json_key_t *key)
+{
+    json_object_t *object;
+
+    if(!key || !json_is_object(json))
+        return -1;
+
+    object = json_to_object(json);
+    return hashtable_del_hashed(&object->hashtable, key->key,
+                                key->len, key->hash);
+}
+
 /*** array ***/
 
-json_t *json_array(void)
+json_t *jsonp_array(jsonp_arena_t *arena)
 {
-    json_array_t *array = jsonp_malloc(sizeof(json_array_t));
+    json_array_t *array = jsonp_arena_pool_malloc(arena, sizeof(json_array_t));
     if(!array)
         return NULL;
     json_init(&array->json, JSON_ARRAY);
@@ -346,26 +458,33 @@ json_t *json_array(void)
     array->entries = 0;
     array->size = 8;
 
-    array->table = jsonp_malloc(array->size * sizeof(json_t *));
+    array->table = jsonp_arena_malloc(arena, array->size * sizeof(json_t *));
     if(!array->table) {
-        jsonp_free(array);
+        jsonp_arena_pool_free(arena, array, sizeof(json_array_t));
         return NULL;
     }
 
-    array->visited = 0;
+    array->arena = jsonp_arena_incref(arena);
 
     return &array->json;
 }
 
+json_t *json_array(void)
+{
+    return jsonp_array(NULL);
+}
+
 static void json_delete_array(json_array_t *array)
 {
+    jsonp_arena_t *arena = array->arena;
     size_t i;
 
     for(i = 0; i < array->entries; i++)
         json_decref(array->table[i]);
 
-    jsonp_free(array->table);
-    jsonp_free(array);
+    jsonp_arena_free(arena, array->table);
+    jsonp_arena_pool_free(arena, array, sizeof(json_array_t));
+    jsonp_arena_decref(arena);
 }
 
 size_t json_array_size(const json_t *json)
@@ -441,7 +560,7 @@ static json_t **json_array_grow(json_array_t *array,
     old_table = array->table;
 
     new_size = max(array->size + amount, array->size * 2);
-    new_table = jsonp_malloc(new_size * sizeof(json_t *));
+    new_table = jsonp_arena_malloc(array->arena, new_size * sizeof(json_t *));
     if(!new_table)
         return NULL;
 
@@ -450,13 +569,40 @@ static json_t **json_array_grow(json_array_t *array,
 
     if(copy) {
         array_copy(array->table, 0, old_table, 0, array->entries);
-        jsonp_free(old_table);
+        jsonp_arena_free(array->arena, old_table);
         return array->table;
     }
 
     return old_table;
 }
 
+int json_array_reserve(json_t *json, size_t size)
+{
+    json_array_t *array;
+    json_t **table;
+
+    if(!json_is_array(json))
+        return -1;
+    array = json_to_array(json);
+
+    if(size <= array->size)
+        return 0;
+    if(size > (size_t)-1 / sizeof(json_t *))
+        return -1;
+
+    /* Unlike json_array_grow(), allocate exactly what was asked for */
+    table = jsonp_arena_malloc(array->arena, size * sizeof(json_t *));
+    if(!table)
+        return -1;
+
+    array_copy(table, 0, array->table, 0, array->entries);
+    jsonp_arena_free(array->arena, array->table);
+
+    array->table = table;
+    array->size = size;
+    return 0;
+}
+
 int json_array_append_new(json_t *json, json_t *value)
 {
     json_array_t *array;
@@ -511,7 +657,7 @@ int json_array_insert_new(json_t *json, size_t index, json_t *value)
         array_copy(array->table, 0, old_table, 0, index);
         array_copy(array->table, index + 1, old_table, index,
                    array->entries - index);
-        jsonp_free(old_table);
+        jsonp_arena_free(array->arena, old_table);
     }
     else
         array_move(array, index + 1, index, array->entries - index);
@@ -636,27 +782,33 @@ static json_t *json_array_deep_copy(const json_t *array)
 
 /*** string ***/
 
-json_t *json_string_nocheck(const char *value)
+json_t *jsonp_stringn_nocheck(jsonp_arena_t *arena, const char *value, size_t len)
 {
     json_string_t *string;
 
-    if(!value)
-        return NULL;
-
-    string = jsonp_malloc(sizeof(json_string_t));
+    string = jsonp_arena_pool_malloc(arena, sizeof(json_string_t));
     if(!string)
         return NULL;
     json_init(&string->json, JSON_STRING);
 
-    string->value = jsonp_strdup(value);
+    string->value = jsonp_arena_strndup(arena, value, len);
     if(!string->value) {
-        jsonp_free(string);
+        jsonp_arena_pool_free(arena, string, sizeof(json_string_t));
         return NULL;
     }
 
+    string->arena = jsonp_arena_incref(arena);
     return &string->json;
 }
 
+json_t *json_string_nocheck(const char *value)
+{
+    if(!value)
+        return NULL;
+
+    return jsonp_stringn_nocheck(NULL, value, strlen(value));
+}
+
 json_t *json_string(const char *value)
 {
     if(!value || !utf8_check_string(value, -1))
@@ -686,7 +838,7 @@ int json_string_set_nocheck(json_t *json, const char *value)
         return -1;
 
     string = json_to_string(json);
-    jsonp_free(string->value);
+    jsonp_arena_free(string->arena, string->value);
     string->value = dup;
 
     return 0;
@@ -702,8 +854,11 @@ int json_string_set(json_t *json, const char *value)
 
 static void json_delete_string(json_string_t *string)
 {
-    jsonp_free(string->value);
-    jsonp_free(string);
+    jsonp_arena_t *arena = string->arena;
+
+    jsonp_arena_free(arena, string->value);
+    jsonp_arena_pool_free(arena, string, sizeof(json_string_t));
+    jsonp_arena_decref(arena);
 }
 
 static int json_string_equal(json_t *string1, json_t *string2)
@@ -719,17 +874,23 @@ static json_t *json_string_copy(const json_t *string)
 
 /*** integer ***/
 
-json_t *json_integer(json_int_t value)
+json_t *jsonp_integer(jsonp_arena_t *arena, json_int_t value)
 {
-    json_integer_t *integer = jsonp_malloc(sizeof(json_integer_t));
+    json_integer_t *integer = jsonp_arena_pool_malloc(arena, sizeof(json_integer_t));
     if(!integer)
         return NULL;
     json_init(&integer->json, JSON_INTEGER);
 
     integer->value = value;
+    integer->arena = jsonp_arena_incref(arena);
     return &integer->json;
 }
 
+json_t *json_integer(json_int_t value)
+{
+    return jsonp_integer(NULL, value);
+}
+
 json_int_t json_integer_value(const json_t *json)
 {
     if(!json_is_integer(json))
@@ -750,7 +911,10 @@ int json_integer_set(json_t *json, json_int_t value)
 
 static void json_delete_integer(json_integer_t *integer)
 {
-    jsonp_free(integer);
+    jsonp_arena_t *arena = integer->arena;
+
+    jsonp_arena_pool_free(arena, integer, sizeof(json_integer_t));
+    jsonp_arena_decref(arena);
 }
 
 static int json_integer_equal(json_t *integer1, json_t *integer2)
@@ -766,22 +930,28 @@ static json_t *json_integer_copy(const json_t *integer)
 
 /*** real ***/
 
-json_t *json_real(double value)
+json_t *jsonp_real(jsonp_arena_t *arena, double value)
 {
     json_real_t *real;
 
     if(isnan(value) || isinf(value))
         return NULL;
 
-    real = jsonp_malloc(sizeof(json_real_t));
+    real = jsonp_arena_pool_malloc(arena, sizeof(json_real_t));
     if(!real)
         return NULL;
     json_init(&real->json, JSON_REAL);
 
     real->value = value;
+    real->arena = jsonp_arena_incref(arena);
     return &real->json;
 }
 
+json_t *json_real(double value)
+{
+    return jsonp_real(NULL, value);
+}
+
 double json_real_value(const json_t *json)
 {
     if(!json_is_real(json))
@@ -802,7 +972,10 @@ int json_real_set(json_t *json, double value)
 
 static void json_delete_real(json_real_t *real)
 {
-    jsonp_free(real);
+    jsonp_arena_t *arena = real->arena;
+
+    jsonp_arena_pool_free(arena, real, sizeof(json_real_t));
+    jsonp_arena_decref(arena);
 }
 
 static int json_real_equal(json_t *real1, json_t *real2)
@@ -964,3 +1137,227 @@ json_t *json_deep_copy(const json_t *json)
 
     return NULL;
 }
+
+
+/*** JSON Pointer ***/
+
+/* Reference tokens up to this length are unescaped on the stack */
+#define PATH_TOKEN_LENGTH 256
+
+/* Unescape the reference token of length len that starts at token
+   ("~1" is "/", "~0" is "~"). The result is written to buffer if it
+   fits, otherwise it's allocated and must be freed by the caller.
+   Returns NULL for invalid escapes. */
+static char *path_unescape(const char *token, size_t len, char *buffer)
+{
+    char *key, *out;
+    size_t i;
+
+    if(len < PATH_TOKEN_LENGTH)
+        key = buffer;
+    else {
+        key = jsonp_malloc(len + 1);
+        if(!key)
+            return NULL;
+    }
+
+    out = key;
+    for(i = 0; i < len; i++)
+    {
+        if(token[i] != '~')
+            *out++ = token[i];
+        else if(i + 1 < len && token[i + 1] == '0')
+            *out++ = '~', i++;
+        else if(i + 1 < len && token[i + 1] == '1')
+            *out++ = '/', i++;
+        else
+        {
+            if(key != buffer)
+                jsonp_free(key);
+            return NULL;
+        }
+    }
+    *out = '\0';
+
+    return key;
+}
+
+/* Parse an array index: "0" or digits without leading zeros */
+static int path_index(const char *key, size_t *index)
+{
+    size_t value = 0;
+
+    if(*key == '\0' || (key[0] == '0' && key[1] != '\0'))
+        return -1;
+
+    for(; *key; key++)
+    {
+        if(*key < '0' || *key > '9' || value > ((size_t)-1 - 9) / 10)
+            return -1;
+        value = value * 10 + (*key - '0');
+    }
+
+    *index = value;
+    return 0;
+}
+
+/* Look up a single unescaped reference token in an object or array */
+static json_t *path_child(const json_t *json, const char *key)
+{
+    size_t index;
+
+    if(json_is_object(json))
+        return json_object_get(json, key);
+
+    if(json_is_array(json) && path_index(key, &index) == 0)
+        return json_array_get(json, index);
+
+    return NULL;
+}
+
+json_t *json_path_get(const json_t *json, const char *path)
+{
+    char buffer[PATH_TOKEN_LENGTH];
+
+    if(!json || !path)
+        return NULL;
+
+    /* The empty path refers to the whole document */
+    while(*path)
+    {
+        size_t len;
+        char *key;
+
+        if(*path != '/')
+            return NULL;
+        path++;
+
+        len = strcspn(path, "/");
+        key = path_unescape(path, len, buffer);
+        if(!key)
+            return NULL;
+
+        json = path_child(json, key);
+        if(key != buffer)
+            jsonp_free(key);
+
+        if(!json)
+            return NULL;
+
+        path += len;
+    }
+
+    return (json_t *)json;
+}
+
+/* Store value under an unescaped reference token in an object or array.
+   An array index may point one past the last element, or be "-", to
+   append. Steals the reference to value. */
+static int path_set_child(json_t *json, const char *key, json_t *value)
+{
+    size_t index;
+
+    if(json_is_object(json))
+        return json_object_set_new(json, key, value);
+
+    if(json_is_array(json))
+    {
+        if(strcmp(key, "-") == 0)
+            return json_array_append_new(json, value);
+
+        if(path_index(key, &index) == 0)
+        {
+            if(index < json_array_size(json))
+                return json_array_set_new(json, index, value);
+            if(index == json_array_size(json))
+                return json_array_append_new(json, value);
+        }
+    }
+
+    json_decref(value);
+    return -1;
+}
+
+int json_path_set_new(json_t *json, const char *path, json_t *value, size_t flags)
+{
+    char buffer[PATH_TOKEN_LENGTH];
+    json_t *parent = NULL, *created = NULL;
+    char *created_key = NULL;
+    int result = -1;
+
+    /* The root itself can't be replaced */
+    if(!json || !path || !value || *path != '/')
+    {
+        json_decref(value);
+        return -1;
+    }
+
+    while(1)
+    {
+        size_t len;
+        char *key;
+        json_t *child;
+
+        path++;
+        len = strcspn(path, "/");
+        key = path_unescape(path, len, buffer);
+        if(!key)
+            break;
+
+        if(path[len] == '\0')
+        {
+            result = path_set_child(json, key, value);
+            value = NULL;
+            if(key != buffer)
+                jsonp_free(key);
+            break;
+        }
+
+        child = path_child(json, key);
+        if(!child && (flags & JSON_PATH_CREATE))
+        {
+            /* A following "-" appends to a new array, everything else
+               is a key in a new object */
+            const char *next = path + len + 1;
+            if(next[0] == '-' && (next[1] == '\0' || next[1] == '/'))
+                child = json_array();
+            else
+                child = json_object();
+
+            if(child && !created)
+            {
+                /* The first missing container is only attached once
+                   the value has been stored, so that a failure leaves
+                   the document as it was */
+                parent = json;
+                created = child;
+                created_key = jsonp_strdup(key);
+                if(!created_key)
+                    child = NULL;
+            }
+            else if(!child || path_set_child(json, key, child))
+                child = NULL;
+        }
+
+        if(key != buffer)
+            jsonp_free(key);
+
+        if(!child)
+            break;
+
+        json = child;
+        path += len;
+    }
+
+    if(created)
+    {
+        if(result == 0)
+            result = path_set_child(parent, created_key, created);
+        else
+            json_decref(created);
+        jsonp_free(created_key);
+    }
+
+    json_decref(value);
+    return result;
+}
@@ -354,6 +354,49 @@ static void test_extend(void)
     json_decref(array2);
 }
 
+static void test_reserve(void)
+{
+    json_t *array, *five;
+    int i;
+
+    array = json_array();
+    five = json_integer(5);
+    if(!array || !five)
+        fail("unable to create values");
+
+    for(i = 0; i < 3; i++) {
+        if(json_array_append(array, five))
+            fail("unable to append");
+    }
+
+    if(json_array_reserve(array, 100))
+        fail("unable to reserve");
+    if(json_array_size(array) != 3)
+        fail("reserving changed the array size");
+    if(json_array_reserve(array, 10))
+        fail("unable to reserve less than there is room for");
+
+    for(i = 3; i < 100; i++) {
+        if(json_array_append(array, five))
+            fail("unable to append after reserving");
+    }
+
+    for(i = 0; i < 100; i++) {
+        if(json_array_get(array, i) != five)
+            fail("invalid array contents after reserving");
+    }
+
+    if(!json_array_reserve(five, 10))
+        fail("reserving room in a non-array succeeded");
+    if(!json_array_reserve(array, (size_t)-1 / sizeof(json_t *) + 1))
+        fail("reserving an overflowing size succeeded");
+    if(json_array_size(array) != 100)
+        fail("failed reserve changed the array");
+
+    json_decref(five);
+    json_decref(array);
+}
+
 static void test_circular()
 {
     json_t *array1, *array2;
@@ -427,6 +470,7 @@ static void run_tests()
     test_remove();
     test_clear();
     test_extend();
+    test_reserve();
     test_circular();
     test_array_foreach();
 }
@@ -6,6 +6,8 @@
  */
 
 #include <jansson.h>
+#include <limits.h>
+#include <stdio.h>
 #include <string.h>
 #include "util.h"
 
@@ -116,6 +118,23 @@ static void circular_references()
     free(result);
 
     json_decref(json);
+
+    /* The same value in several places is no circular reference */
+    json = json_object();
+    json_object_set_new(json, "a", json_array());
+    json_object_set(json, "b", json_object_get(json, "a"));
+    json_array_append_new(json_object_get(json, "a"), json_object());
+    json_array_append(json_object_get(json, "a"),
+                      json_array_get(json_object_get(json, "a"), 0));
+
+    result = json_dumps(json, JSON_COMPACT);
+    if(!result || strcmp(result, "{\"a\":[{},{}],\"b\":[{},{}]}"))
+        fail("json_dumps failed for a shared value!");
+    if(json_dump_size(json, JSON_COMPACT) != strlen(result))
+        fail("json_dump_size failed for a shared value!");
+    free(result);
+
+    json_decref(json);
 }
 
 static void encode_other_than_array_or_object()
@@ -180,6 +199,150 @@ static void escape_slashes()
     json_decref(json);
 }
 
+static void dump_size()
+{
+    /* json_dump_size() must agree with json_dumps() for every flag */
+
+    static const size_t flags[] = {
+        0,
+        JSON_COMPACT,
+        JSON_INDENT(4),
+        JSON_INDENT(2) | JSON_SORT_KEYS,
+        JSON_ENSURE_ASCII,
+        JSON_ESCAPE_SLASH | JSON_COMPACT,
+        JSON_INDENT(31) | JSON_ENSURE_ASCII | JSON_PRESERVE_ORDER
+    };
+
+    json_t *json, *circular;
+    char *result;
+    size_t i;
+
+    json = json_pack("{s:[i,I,i,f,f,n,b,b,[],{}],s:s,s:s,s:{s:[[i],{}]}}",
+                     "numbers", 0, (json_int_t)-9223372036854775807LL - 1,
+                     -42, 1.5, -1e300, 1, 0,
+                     "text", "\"\\/\b\f\n\r\t\x01\x7f",
+                     "h\xc3\xa9llo", "\xe2\x82\xac \xf0\x9d\x84\x9e",
+                     "nested", "a/b", 1);
+    if(!json)
+        fail("json_pack failed");
+
+    for(i = 0; i < sizeof(flags) / sizeof(flags[0]); i++)
+    {
+        result = json_dumps(json, flags[i]);
+        if(!result)
+            fail("json_dumps failed");
+
+        if(json_dump_size(json, flags[i]) != strlen(result))
+            fail("json_dump_size returned a wrong size");
+
+        free(result);
+    }
+
+    if(json_dump_size(json_object_get(json, "text"), 0) != 0)
+        fail("json_dump_size didn't fail for a string without JSON_ENCODE_ANY");
+
+    if(json_dump_size(json_object_get(json, "text"), JSON_ENCODE_ANY) != 24)
+        fail("json_dump_size returned a wrong size for a string");
+
+    circular = json_array();
+    json_array_append_new(circular, json_array());
+    json_array_append(json_array_get(circular, 0), circular);
+    if(json_dump_size(circular, 0) != 0)
+        fail("json_dump_size didn't fail for a circular reference");
+    json_array_clear(json_array_get(circular, 0));
+    json_decref(circular);
+
+    json_decref(json);
+}
+
+static void long_strings()
+{
+    /* Test escapes between runs longer than one scan step */
+
+    json_t *json;
+    char *result;
+    size_t flags = JSON_ENSURE_ASCII | JSON_ESCAPE_SLASH;
+
+    json = json_string("abcdefghijklmnopqrstuvwxyz/0123456789\t"
+                       "abcdefghijklmnopqrstuvwxyz\xc3\xa4\"0123456789");
+
+    result = json_dumps(json, JSON_ENCODE_ANY);
+    if(!result || strcmp(result, "\"abcdefghijklmnopqrstuvwxyz/0123456789\\t"
+                                 "abcdefghijklmnopqrstuvwxyz\xc3\xa4\\\"0123456789\""))
+        fail("json_dumps failed to encode a long string");
+    if(json_dump_size(json, JSON_ENCODE_ANY) != strlen(result))
+        fail("json_dump_size returned a wrong size for a long string");
+    free(result);
+
+    result = json_dumps(json, JSON_ENCODE_ANY | flags);
+    if(!result || strcmp(result, "\"abcdefghijklmnopqrstuvwxyz\\/0123456789\\t"
+                                 "abcdefghijklmnopqrstuvwxyz\\u00e4\\\"0123456789\""))
+        fail("json_dumps failed to escape a long string");
+    if(json_dump_size(json, JSON_ENCODE_ANY | flags) != strlen(result))
+        fail("json_dump_size returned a wrong size for an escaped string");
+    free(result);
+
+    json_decref(json);
+}
+
+static void encode_reals()
+{
+    /* Test that reals are encoded with their shortest digits */
+
+    static const struct {
+        double value;
+        const char *text;
+    } reals[] = {
+        {0.1, "0.1"},
+        {-0.0, "-0.0"},
+        {100.0, "100.0"},
+        {123.456789, "123.456789"},
+        {0.001234, "0.001234"},
+        {1.5e-7, "1.5e-7"},
+        {1e22, "1e22"},
+        {5e-324, "5e-324"},
+        {1.7976931348623157e308, "1.7976931348623157e308"}
+    };
+    size_t i;
+
+    for(i = 0; i < sizeof(reals) / sizeof(reals[0]); i++) {
+        json_t *json = json_real(reals[i].value);
+        char *result = json_dumps(json, JSON_ENCODE_ANY);
+
+        if(!result || strcmp(result, reals[i].text))
+            fail("json_dumps encoded a real wrong");
+
+        free(result);
+        json_decref(json);
+    }
+}
+
+static void encode_integers()
+{
+    /* Test the integer encoder, including the edges of json_int_t */
+
+#if JSON_INTEGER_IS_LONG_LONG
+    json_int_t values[] = {0, 7, -10, 1234567, LLONG_MAX, LLONG_MIN};
+#else
+    json_int_t values[] = {0, 7, -10, 1234567, LONG_MAX, LONG_MIN};
+#endif
+    size_t i;
+
+    for(i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        json_t *json = json_integer(values[i]);
+        char *result = json_dumps(json, JSON_ENCODE_ANY);
+        char expected[32];
+
+        snprintf(expected, sizeof(expected), "%" JSON_INTEGER_FORMAT,
+                 values[i]);
+        if(!result || strcmp(result, expected))
+            fail("json_dumps encoded an integer wrong");
+
+        free(result);
+        json_decref(json);
+    }
+}
+
 static void run_tests()
 {
     encode_null();
@@ -187,4 +350,8 @@ static void run_tests()
     circular_references();
     encode_other_than_array_or_object();
     escape_slashes();
+    dump_size();
+    long_strings();
+    encode_reals();
+    encode_integers();
 }
@@ -6,6 +6,8 @@
  */
 
 #include <jansson.h>
+#include <limits.h>
+#include <stdio.h>
 #include <string.h>
 #include "util.h"
 
@@ -154,6 +156,207 @@ static void position()
     json_decref(json);
 }
 
+static void load_stream()
+{
+    /* Read a file that spans several read blocks, with multi-byte UTF-8
+       sequences falling on the block boundaries */
+
+    json_t *json, *item;
+    json_error_t error;
+    FILE *fp;
+    size_t i;
+    int c;
+
+    fp = tmpfile();
+    if(!fp)
+        fail("tmpfile failed");
+
+    fputc('[', fp);
+    for(i = 0; i < 40000; i++)
+        fprintf(fp, "%s\"\xe2\x82\xac%lu\"", i ? "," : "", (unsigned long)i);
+    fputs("] rest", fp);
+    rewind(fp);
+
+    json = json_loadf(fp, 0, &error);
+    if(json)
+        fail("json_loadf did not detect garbage after a large JSON text");
+    check_error("end of file expected near 'rest'", "<stream>", 1, 348896, 428896);
+
+    rewind(fp);
+    json = json_loadf(fp, JSON_DISABLE_EOF_CHECK, &error);
+    if(!json || json_array_size(json) != 40000)
+        fail("json_loadf failed to load a large JSON text");
+
+    item = json_array_get(json, 39999);
+    if(!item || strcmp(json_string_value(item), "\xe2\x82\xac" "39999") != 0)
+        fail("json_loadf decoded a wrong value");
+    json_decref(json);
+
+    /* Only the JSON text may be consumed from the stream */
+    c = fgetc(fp);
+    if(c != ' ' && c != 'r')
+        fail("json_loadf read past the end of the JSON text");
+
+    fclose(fp);
+}
+
+static void map_file()
+{
+    json_t *json;
+    json_error_t error;
+    FILE *fp;
+
+    json = json_load_file("/path/to/nonexistent/file.json", JSON_MAP_FILE, &error);
+    if(json)
+        fail("json_load_file returned non-NULL for a nonexistent file");
+
+    fp = fopen("map_file.json", "wb");
+    if(!fp)
+        fail("unable to create a test file");
+    fputs("{\"foo\": [1, 2, 3]} ", fp);
+    fclose(fp);
+
+    json = json_load_file("map_file.json", JSON_MAP_FILE, &error);
+    if(!json || json_array_size(json_object_get(json, "foo")) != 3)
+        fail("json_load_file failed to load a mapped file");
+    if(error.position != 19)
+        fail("json_load_file returned a wrong position for a mapped file");
+    json_decref(json);
+
+    fp = fopen("map_file.json", "wb");
+    if(!fp)
+        fail("unable to create a test file");
+    fputs("{\"foo\": 1} garbage", fp);
+    fclose(fp);
+
+    if(json_load_file("map_file.json", JSON_MAP_FILE, &error))
+        fail("json_load_file did not detect garbage in a mapped file");
+    check_error("end of file expected near 'garbage'", "map_file.json", 1, 18, 18);
+
+    /* Empty files can't be mapped and go through stdio */
+    fp = fopen("map_file.json", "wb");
+    if(!fp)
+        fail("unable to create a test file");
+    fclose(fp);
+
+    if(json_load_file("map_file.json", JSON_MAP_FILE, &error))
+        fail("json_load_file did not fail for an empty mapped file");
+    check_error("'[' or '{' expected near end of file", "map_file.json", 1, 0, 0);
+
+    remove("map_file.json");
+}
+
+static void long_strings()
+{
+    json_t *json;
+    json_error_t error;
+
+    /* runs of plain characters longer than one scan step, with escapes
+       and multi-byte characters in between */
+    json = json_loads("[\"abcdefghijklmnopqrstuvwxyz0123456789\","
+                      "  \"abcdefghijklmnop\\tqrstuvwxyz \\u00e4\\\"\","
+                      "\n\t\"\xc3\xa4" "bcdefghijklmnopqrstuvwxyz\"]", 0, &error);
+    if(!json)
+        fail("json_loads failed on long strings");
+    if(strcmp(json_string_value(json_array_get(json, 0)),
+              "abcdefghijklmnopqrstuvwxyz0123456789"))
+        fail("json_loads decoded a plain string wrong");
+    if(strcmp(json_string_value(json_array_get(json, 1)),
+              "abcdefghijklmnop\tqrstuvwxyz \xc3\xa4\""))
+        fail("json_loads decoded an escaped string wrong");
+    if(strcmp(json_string_value(json_array_get(json, 2)),
+              "\xc3\xa4" "bcdefghijklmnopqrstuvwxyz"))
+        fail("json_loads decoded a multi-byte string wrong");
+    json_decref(json);
+
+    json = json_loads("[\n  \"abcdefghijklmnopqrstuvwxyz\n\"]", 0, &error);
+    if(json)
+        fail("json_loads accepted a newline in a string");
+    check_error("unexpected newline",
+                "<string>", 2, 29, 31);
+}
+
+static void integers()
+{
+    json_t *json;
+    json_error_t error;
+    char text[64];
+#if JSON_INTEGER_IS_LONG_LONG
+    json_int_t max = LLONG_MAX, min = LLONG_MIN;
+#else
+    json_int_t max = LONG_MAX, min = LONG_MIN;
+#endif
+
+    snprintf(text, sizeof(text), "[0, -0, -1, %" JSON_INTEGER_FORMAT
+             ", %" JSON_INTEGER_FORMAT "]", max, min);
+    json = json_loads(text, 0, &error);
+    if(!json)
+        fail("json_loads failed on integers");
+    if(json_integer_value(json_array_get(json, 1)) != 0 ||
+       json_integer_value(json_array_get(json, 2)) != -1 ||
+       json_integer_value(json_array_get(json, 3)) != max ||
+       json_integer_value(json_array_get(json, 4)) != min)
+        fail("json_loads decoded an integer wrong");
+    json_decref(json);
+
+    json = json_loads("[12345678901234567890]", 0, &error);
+    if(json)
+        fail("json_loads accepted a too big integer");
+    check_error("too big integer near '12345678901234567890'", "<string>",
+                1, 21, 21);
+}
+
+static void object_keys()
+{
+    json_t *json, *inner;
+    json_error_t error;
+    const char *long_key =
+        "key-abcdefghijklmnopqrstuvwxyz-abcdefghijklmnopqrstuvwxyz-abcdefghijklmnopqrstuvwxyz";
+
+    /* keys longer than the stack buffer, and keys that must survive
+       parsing a nested value */
+    json = json_loads("{\"key-abcdefghijklmnopqrstuvwxyz-abcdefghijklmnopqrstuvwxyz-"
+                      "abcdefghijklmnopqrstuvwxyz\": {\"a\\u00e4\": \"value\","
+                      " \"b\": [\"x\", \"y\"]}, \"c\": \"d\"}", 0, &error);
+    if(!json)
+        fail("json_loads failed on object keys");
+
+    inner = json_object_get(json, long_key);
+    if(!json_is_object(inner))
+        fail("json_loads lost a long key");
+    if(strcmp(json_string_value(json_object_get(inner, "a\xc3\xa4")), "value"))
+        fail("json_loads decoded an escaped key wrong");
+    if(json_array_size(json_object_get(inner, "b")) != 2)
+        fail("json_loads lost a key of a nested value");
+    if(strcmp(json_string_value(json_object_get(json, "c")), "d"))
+        fail("json_loads lost a key after a nested object");
+    json_decref(json);
+}
+
+static void arena_alloc()
+{
+    const char *text =
+        "{\"string\": \"abc\\u00e4\", \"integer\": 42, \"real\": 1.5,"
+        " \"array\": [true, false, null, [], {}], \"object\": {\"a\": [1, 2]}}";
+    json_t *json, *expected;
+    json_error_t error;
+
+    expected = json_loads(text, 0, &error);
+    json = json_loads(text, JSON_ARENA_ALLOC, &error);
+    if(!json)
+        fail("json_loads failed with JSON_ARENA_ALLOC");
+    if(!json_equal(json, expected))
+        fail("json_loads decoded a different value with JSON_ARENA_ALLOC");
+    json_decref(json);
+
+    json = json_loads("{\"a\": [1, 2", JSON_ARENA_ALLOC, &error);
+    if(json)
+        fail("json_loads accepted a truncated input with JSON_ARENA_ALLOC");
+    check_error("']' expected near end of file", "<string>", 1, 11, 11);
+
+    json_decref(expected);
+}
+
 static void run_tests()
 {
     file_not_found();
@@ -163,4 +366,10 @@ static void run_tests()
     decode_int_as_real();
     load_wrong_args();
     position();
+    load_stream();
+    map_file();
+    long_strings();
+    integers();
+    object_keys();
+    arena_alloc();
 }
@@ -1,3 +1,4 @@
+#include <stdio.h>
 #include <string.h>
 #include <jansson.h>
 
@@ -75,8 +76,107 @@ static void test_secure_funcs(void)
     create_and_free_complex_object();
 }
 
+/* Values decoded into an arena, then changed and kept alive on their
+   own, must still release every allocation in the end */
+
+static int live_allocations = 0;
+
+static void *counting_malloc(size_t size)
+{
+    live_allocations++;
+    return malloc(size);
+}
+
+static void counting_free(void *ptr)
+{
+    live_allocations--;
+    free(ptr);
+}
+
+static void test_arena()
+{
+    json_t *json, *array, *string;
+    json_error_t error;
+    int i;
+
+    json_set_alloc_funcs(counting_malloc, counting_free);
+
+    json = json_loads("{\"foo\": [1, 2.5, \"bar\"], \"baz\": \"qux\","
+                      " \"nested\": {\"a\": null}}", JSON_ARENA_ALLOC, &error);
+    if(!json)
+        fail("json_loads failed with JSON_ARENA_ALLOC");
+
+    /* grow, replace and delete memory that came from the arena */
+    array = json_object_get(json, "foo");
+    for(i = 0; i < 20; i++)
+        json_array_append_new(array, json_integer(i));
+    for(i = 0; i < 20; i++) {
+        char key[8];
+        sprintf(key, "k%d", i);
+        json_object_set_new(json, key, json_string(key));
+    }
+    json_string_set(json_object_get(json, "baz"), "quux");
+    json_object_del(json, "nested");
+
+    string = json_incref(json_array_get(array, 2));
+    json_decref(json);
+
+    if(live_allocations == 0)
+        fail("arena was freed while a value was still alive");
+    if(strcmp(json_string_value(string), "bar"))
+        fail("value from an arena has changed");
+
+    json_decref(string);
+    if(live_allocations != 0)
+        fail("arena leaked memory");
+
+    json_set_alloc_funcs(malloc, free);
+}
+
+static void test_pool()
+{
+    json_t *json, *reused;
+    char key[32];
+    int i;
+
+    json_set_alloc_funcs(malloc, free);
+
+    /* a freed value is handed out again for the next one of its size */
+    json = json_integer(1);
+    json_decref(json);
+    reused = json_integer(2);
+    if(reused != json)
+        fail("freed value was not reused");
+    json_decref(reused);
+
+    /* pairs of different sizes share the blocks of their size class */
+    json = json_object();
+    for(i = 0; i < 1000; i++) {
+        sprintf(key, "%.*s%d", i % 20, "abcdefghijklmnopqrst", i);
+        json_object_set_new(json, key, json_integer(i));
+    }
+    for(i = 0; i < 1000; i += 2) {
+        sprintf(key, "%.*s%d", i % 20, "abcdefghijklmnopqrst", i);
+        json_object_del(json, key);
+    }
+    for(i = 0; i < 1000; i += 2) {
+        sprintf(key, "%.*s%d", (i + 1) % 20, "abcdefghijklmnopqrst", i);
+        json_object_set_new(json, key, json_integer(i));
+    }
+    for(i = 0; i < 1000; i++) {
+        sprintf(key, "%.*s%d", (i + !(i % 2)) % 20, "abcdefghijklmnopqrst", i);
+        if(json_integer_value(json_object_get(json, key)) != i)
+            fail("pooled pair was corrupted");
+    }
+    json_decref(json);
+
+    json_pool_flush();
+}
+
 static void run_tests()
 {
     test_simple();
     test_secure_funcs();
+    test_arena();
+    test_pool();
 }
@@ -6,6 +6,7 @@
  */
 
 #include <jansson.h>
+#include <stdio.h>
 #include <string.h>
 #include "util.h"
 
@@ -513,6 +514,317 @@ static void test_object_foreach()
     json_decref(object2);
 }
 
+static void test_path_get()
+{
+    json_t *json, *value;
+    char long_key[300];
+
+    json = json_pack("{s:[i,{s:{s:i}}], s:i, s:i, s:i, s:[]}",
+                     "players", 5, "stats", "kills", 12,
+                     "a/b", 1, "m~n", 2, "", 3, "empty");
+    if(!json)
+        fail("unable to create object");
+
+    if(json_path_get(json, "") != json)
+        fail("json_path_get failed for the root");
+
+    value = json_path_get(json, "/players/1/stats/kills");
+    if(!json_is_integer(value) || json_integer_value(value) != 12)
+        fail("json_path_get failed for a nested value");
+
+    value = json_path_get(json, "/players/0");
+    if(!json_is_integer(value) || json_integer_value(value) != 5)
+        fail("json_path_get failed for an array element");
+
+    value = json_path_get(json, "/a~1b");
+    if(!json_is_integer(value) || json_integer_value(value) != 1)
+        fail("json_path_get failed to unescape ~1");
+
+    value = json_path_get(json, "/m~0n");
+    if(!json_is_integer(value) || json_integer_value(value) != 2)
+        fail("json_path_get failed to unescape ~0");
+
+    value = json_path_get(json, "/");
+    if(!json_is_integer(value) || json_integer_value(value) != 3)
+        fail("json_path_get failed for the empty key");
+
+    if(json_path_get(json, "players") ||
+       json_path_get(json, "/players/01") ||
+       json_path_get(json, "/players/-") ||
+       json_path_get(json, "/players/2") ||
+       json_path_get(json, "/players/0/x") ||
+       json_path_get(json, "/empty/0") ||
+       json_path_get(json, "/m~2n") ||
+       json_path_get(json, "/missing") ||
+       json_path_get(NULL, "") ||
+       json_path_get(json, NULL))
+        fail("json_path_get returned a value for an invalid path");
+
+    /* Keys that don't fit the stack buffer */
+    long_key[0] = '/';
+    memset(long_key + 1, 'k', sizeof(long_key) - 2);
+    long_key[sizeof(long_key) - 1] = '\0';
+    json_object_set_new(json, long_key + 1, json_integer(4));
+
+    value = json_path_get(json, long_key);
+    if(!json_is_integer(value) || json_integer_value(value) != 4)
+        fail("json_path_get failed for a long key");
+
+    json_decref(json);
+}
+
+static void test_path_set()
+{
+    json_t *json, *value;
+
+    json = json_object();
+    if(!json)
+        fail("unable to create object");
+
+    if(!json_path_set_new(json, "/a/b", json_integer(1), 0))
+        fail("json_path_set_new created a missing value without JSON_PATH_CREATE");
+    if(json_object_size(json) != 0)
+        fail("json_path_set_new modified the object on error");
+
+    if(json_path_set_new(json, "/a/b", json_integer(1), JSON_PATH_CREATE))
+        fail("json_path_set_new failed to create a missing object");
+    if(json_integer_value(json_path_get(json, "/a/b")) != 1)
+        fail("json_path_set_new stored a wrong value");
+
+    if(json_path_set_new(json, "/a/b", json_integer(2), 0))
+        fail("json_path_set_new failed to replace a value");
+    if(json_integer_value(json_path_get(json, "/a/b")) != 2)
+        fail("json_path_set_new didn't replace a value");
+
+    if(json_path_set_new(json, "/list/-/name", json_string("x"), JSON_PATH_CREATE) ||
+       json_path_set_new(json, "/list/1", json_integer(3), 0) ||
+       json_path_set_new(json, "/list/-", json_integer(4), 0) ||
+       json_path_set_new(json, "/list/a~1b/c", json_true(), JSON_PATH_CREATE) == 0)
+        fail("json_path_set_new failed for an array");
+
+    value = json_path_get(json, "/list");
+    if(!json_is_array(value) || json_array_size(value) != 3 ||
+       strcmp(json_string_value(json_path_get(value, "/0/name")), "x") != 0 ||
+       json_integer_value(json_array_get(value, 2)) != 4)
+        fail("json_path_set_new built a wrong array");
+
+    if(!json_path_set_new(json, "/list/5", json_integer(5), 0))
+        fail("json_path_set_new set an array index out of range");
+
+    /* Existing scalars are never replaced by containers */
+    if(!json_path_set_new(json, "/a/b/c", json_integer(5), JSON_PATH_CREATE))
+        fail("json_path_set_new replaced a scalar");
+
+    /* Containers created for a failed call are not left behind */
+    if(!json_path_set_new(json, "/new/list/-/\xff", json_integer(5), JSON_PATH_CREATE) ||
+       !json_path_set_new(json, "/list/7/name", json_integer(5), JSON_PATH_CREATE))
+        fail("json_path_set_new accepted an invalid key");
+    if(json_object_get(json, "new") || json_array_size(json_object_get(json, "list")) != 3)
+        fail("json_path_set_new modified the object on error");
+
+    value = json_integer(6);
+    if(json_path_set(json, "/1~02", value, 0) || value->refcount != 2)
+        fail("json_path_set failed");
+    if(json_path_get(json, "/1~02") != value || !json_object_get(json, "1~2"))
+        fail("json_path_set used a wrong key");
+    json_decref(value);
+
+    if(!json_path_set_new(json, "", json_integer(7), 0) ||
+       !json_path_set_new(json, "a", json_integer(7), 0) ||
+       !json_path_set_new(json, "/a~", json_integer(7), 0) ||
+       !json_path_set_new(json, "/a", NULL, 0))
+        fail("json_path_set_new accepted an invalid path");
+
+    json_decref(json);
+}
+
+static void test_few_keys()
+{
+    json_t *object;
+    const char *keys[] = {"a", "ab", "abc", "b", "ba", "c", "d", "e", "f", "g"};
+    int i;
+
+    object = json_object();
+    if(!object)
+        fail("unable to create object");
+
+    /* fill up a small object, then grow it past the point where it
+       needs an index */
+    for(i = 0; i < 8; i++)
+        json_object_set_new(object, keys[i], json_integer(i));
+
+    json_object_del(object, "abc");
+    if(json_object_get(object, "abc") || json_object_size(object) != 7)
+        fail("unable to delete from a small object");
+    json_object_set_new(object, "abc", json_integer(2));
+
+    for(i = 8; i < 10; i++)
+        json_object_set_new(object, keys[i], json_integer(i));
+
+    if(json_object_size(object) != 10)
+        fail("object has the wrong size after growing");
+
+    for(i = 0; i < 10; i++) {
+        if(json_integer_value(json_object_get(object, keys[i])) != i)
+            fail("key was lost while growing a small object");
+    }
+
+    if(json_object_get(object, "") || json_object_get(object, "abcd"))
+        fail("found a key that was never set");
+
+    json_decref(object);
+}
+
+static void test_many_keys()
+{
+    json_t *object;
+    void *iter;
+    char key[16];
+    int i, count;
+
+    object = json_object();
+    if(!object)
+        fail("unable to create object");
+
+    /* enough keys to grow the table a few times, then delete every
+       third one so that collided keys have to be moved back */
+    for(i = 0; i < 1000; i++) {
+        sprintf(key, "key%d", i);
+        if(json_object_set_new(object, key, json_integer(i)))
+            fail("unable to set a key");
+    }
+
+    for(i = 0; i < 1000; i += 3) {
+        sprintf(key, "key%d", i);
+        if(json_object_del(object, key))
+            fail("unable to delete a key");
+    }
+
+    if(json_object_size(object) != 666)
+        fail("object has the wrong size after deleting keys");
+
+    for(i = 0; i < 1000; i++) {
+        json_t *value;
+
+        sprintf(key, "key%d", i);
+        value = json_object_get(object, key);
+        if(i % 3 == 0 && value)
+            fail("deleted key was found");
+        if(i % 3 != 0 && json_integer_value(value) != i)
+            fail("key was lost");
+    }
+
+    /* keys are iterated in the order they were added */
+    count = 0;
+    for(iter = json_object_iter(object); iter;
+        iter = json_object_iter_next(object, iter)) {
+        if(json_integer_value(json_object_iter_value(iter)) % 3 == 0)
+            fail("iterated over a deleted key");
+        count++;
+    }
+    if(count != 666)
+        fail("iterated over the wrong number of keys");
+
+    iter = json_object_iter(object);
+    if(strcmp(json_object_iter_key(iter), "key1"))
+        fail("keys are not iterated in insertion order");
+
+    json_decref(object);
+}
+
+static void test_prepared_keys()
+{
+    json_t *object, *value;
+    json_key_t *key, *other;
+    char buf[16];
+    int i, j;
+
+    key = json_key("kills");
+    if(!key)
+        fail("unable to create key");
+    if(strcmp(json_key_string(key), "kills"))
+        fail("key has the wrong string");
+
+    if(json_key("\xa4"))
+        fail("created a key from invalid UTF-8");
+
+    object = json_object();
+    value = json_integer(1);
+    if(!object || !value)
+        fail("unable to create values");
+
+    /* both a small object and one with an index */
+    for(i = 0; i < 2; i++) {
+        if(json_object_set_key(object, key, value))
+            fail("unable to set a value with a prepared key");
+        if(json_object_get(object, "kills") != value)
+            fail("prepared key set the wrong value");
+        if(json_object_get_key(object, key) != value)
+            fail("unable to get a value with a prepared key");
+
+        json_object_set_new(object, "kills", json_integer(2));
+        if(json_integer_value(json_object_get_key(object, key)) != 2)
+            fail("prepared key does not find a plain key");
+
+        if(json_object_del_key(object, key))
+            fail("unable to delete a value with a prepared key");
+        if(json_object_get(object, "kills") || !json_object_del_key(object, key))
+            fail("prepared key was not deleted");
+
+        for(j = 0; j < 20; j++) {
+            snprintf(buf, sizeof(buf), "key%d", j);
+            json_object_set_new(object, buf, json_integer(j));
+        }
+    }
+
+    other = json_key("deaths");
+    if(json_object_get_key(object, other))
+        fail("prepared key found a value that was never set");
+    if(!json_object_set_new_key(object, NULL, json_integer(1)) ||
+       !json_object_set_new_key(value, other, json_integer(1)) ||
+       json_object_get_key(object, NULL))
+        fail("prepared keys accept invalid arguments");
+
+    json_key_free(other);
+    json_key_free(key);
+    json_decref(value);
+    json_decref(object);
+}
+
+static void test_revision()
+{
+    json_t *object;
+    size_t revision;
+
+    object = json_object();
+    if(!object)
+        fail("unable to create object");
+
+    revision = json_object_revision(object);
+    json_object_set_new(object, "a", json_integer(1));
+    if(json_object_revision(object) == revision)
+        fail("adding a key didn't change the revision");
+
+    revision = json_object_revision(object);
+    json_object_set_new(object, "a", json_integer(2));
+    if(json_object_revision(object) != revision)
+        fail("replacing a value changed the revision");
+
+    json_object_del(object, "a");
+    if(json_object_revision(object) == revision)
+        fail("deleting a key didn't change the revision");
+
+    revision = json_object_revision(object);
+    json_object_clear(object);
+    if(json_object_revision(object) == revision)
+        fail("clearing the object didn't change the revision");
+
+    if(json_object_revision(NULL) != 0)
+        fail("json_object_revision returned nonzero for NULL");
+
+    json_decref(object);
+}
+
 static void run_tests()
 {
     test_misc();
@@ -524,4 +836,10 @@ static void run_tests()
     test_iterators();
     test_preserve_order();
     test_object_foreach();
+    test_path_get();
+    test_path_set();
+    test_few_keys();
+    test_many_keys();
+    test_prepared_keys();
+    test_revision();
 }
@@ -17,6 +17,69 @@
 #include <stdio.h>
 #include "util.h"
 
+struct arg_list {
+    const char *types;
+    const json_arg_t *args;
+    size_t pos;
+};
+
+static int next_arg(char type, json_arg_t *arg, void *data)
+{
+    struct arg_list *list = data;
+
+    if(!list->types[list->pos] || list->types[list->pos] != type)
+        return -1;
+
+    *arg = list->args[list->pos++];
+    return 0;
+}
+
+static void pack_callback()
+{
+    json_t *value, *inner;
+    json_error_t error;
+    json_arg_t args[8];
+    struct arg_list list;
+
+    inner = json_integer(7);
+
+    args[0].string = "name";
+    args[1].string = "foo";
+    args[2].string = "bar";
+    args[3].integer = 3;
+    args[4].string = "list";
+    args[5].integer = 1;
+    args[6].real = 1.5;
+    args[7].json = inner;
+    list.types = "sss#sbfO";
+    list.args = args;
+    list.pos = 0;
+
+    value = json_pack_callback(&error, 0, "{s:s+#, s:[bfO]}", next_arg, &list);
+    if(!value || list.pos != 8)
+        fail("json_pack_callback failed");
+
+    if(strcmp(json_string_value(json_object_get(value, "name")), "foobar") != 0 ||
+       !json_is_true(json_array_get(json_object_get(value, "list"), 0)) ||
+       json_real_value(json_array_get(json_object_get(value, "list"), 1)) != 1.5 ||
+       json_array_get(json_object_get(value, "list"), 2) != inner ||
+       inner->refcount != 2)
+        fail("json_pack_callback packed a wrong value");
+    json_decref(value);
+
+    /* Running out of arguments */
+    list.pos = 0;
+    list.types = "sss";
+    if(json_pack_callback(&error, 0, "{s:s+#, s:[bfO]}", next_arg, &list))
+        fail("json_pack_callback didn't fail for a missing argument");
+    check_error("Missing or invalid argument for '#'", "<args>", 1, 6, 6);
+
+    if(json_pack_callback(&error, 0, "i", NULL, NULL))
+        fail("json_pack_callback didn't fail for a NULL callback");
+
+    json_decref(inner);
+}
+
 static void run_tests()
 {
     json_t *value;
@@ -280,4 +343,6 @@ static void run_tests()
     if(json_pack_ex(&error, 0, "{s:s}", "foo", "\xff\xff"))
         fail("json_pack failed to catch invalid UTF-8 in a string");
     check_error("Invalid UTF-8 string", "<args>", 1, 4, 4);
+
+    pack_callback();
 }
@@ -11,6 +11,64 @@
 #include <stdio.h>
 #include "util.h"
 
+struct target_list {
+    const char *types;
+    void **targets;
+    size_t pos;
+};
+
+static int next_target(char type, json_arg_t *arg, void *data)
+{
+    struct target_list *list = data;
+
+    if(!list->types[list->pos] || list->types[list->pos] != type)
+        return -1;
+
+    if(type == 'k')
+        arg->string = list->targets[list->pos++];
+    else
+        arg->target = list->targets[list->pos++];
+    return 0;
+}
+
+static void unpack_callback()
+{
+    json_t *j, *o;
+    json_error_t error;
+    const char *s;
+    int i;
+    double f;
+    void *targets[7];
+    struct target_list list;
+
+    j = json_pack("{s:s, s:[i, f, {}]}", "name", "foo", "list", 42, 1.5);
+
+    targets[0] = "name";
+    targets[1] = &s;
+    targets[2] = "list";
+    targets[3] = &i;
+    targets[4] = &f;
+    targets[5] = &o;
+    list.types = "kskiFO";
+    list.targets = targets;
+    list.pos = 0;
+
+    if(json_unpack_callback(j, &error, 0, "{s:s, s:[iFO]}", next_target, &list))
+        fail("json_unpack_callback failed");
+    if(strcmp(s, "foo") != 0 || i != 42 || f != 1.5 || !json_is_object(o) ||
+       o->refcount != 2)
+        fail("json_unpack_callback unpacked a wrong value");
+    json_decref(o);
+
+    list.pos = 0;
+    list.types = "ks";
+    if(!json_unpack_callback(j, &error, 0, "{s:s, s:[iFO]}", next_target, &list))
+        fail("json_unpack_callback didn't fail for a missing argument");
+    check_error("Missing or invalid argument for 'k'", "<args>", 1, 7, 7);
+
+    json_decref(j);
+}
+
 static void run_tests()
 {
     json_t *j, *j2;
@@ -370,4 +428,6 @@ static void run_tests()
     if(i1 != 42)
         fail("json_unpack failed to unpack");
     json_decref(j);
+
+    unpack_callback();
 }
@@ -0,0 +1,147 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SMJansson
+ * Background worker support for JSON jobs.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "workerpool.h"
+#include "jansson/src/jansson.h"
+
+JanssonWorkerPool g_JanssonWorkerPool;
+
+JanssonWorkerPool::JanssonWorkerPool() : m_JobCount(0), m_bRunning(false) {
+}
+
+bool JanssonWorkerPool::Start(unsigned int threads) {
+	std::lock_guard<std::mutex> lock(m_Lock);
+	if(m_bRunning) {
+		return true;
+	}
+
+	if(threads < 1) {
+		threads = 1;
+	} else if(threads > JANSSON_MAX_WORKER_THREADS) {
+		threads = JANSSON_MAX_WORKER_THREADS;
+	}
+
+	m_bRunning = true;
+	for(unsigned int i = 0; i < threads; i++) {
+		m_Threads.push_back(std::thread(&JanssonWorkerPool::ThreadMain, this));
+	}
+
+	return true;
+}
+
+void JanssonWorkerPool::Shutdown() {
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		if(!m_bRunning) {
+			return;
+		}
+
+		m_bRunning = false;
+	}
+
+	m_Signal.notify_all();
+	for(size_t i = 0; i < m_Threads.size(); i++) {
+		m_Threads[i].join();
+	}
+	m_Threads.clear();
+
+	// Nobody is left to wait for these, just release what they hold.
+	while(!m_Pending.empty()) {
+		delete m_Pending.front();
+		m_Pending.pop_front();
+	}
+
+	while(!m_Completed.empty()) {
+		delete m_Completed.front();
+		m_Completed.pop_front();
+	}
+
+	m_JobCount = 0;
+}
+
+bool JanssonWorkerPool::AddJob(JanssonJob *job) {
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		if(!m_bRunning) {
+			return false;
+		}
+
+		m_Pending.push_back(job);
+		m_JobCount++;
+	}
+
+	m_Signal.notify_one();
+	return true;
+}
+
+void JanssonWorkerPool::ProcessCompleted() {
+	std::deque<JanssonJob *> completed;
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		if(m_Completed.empty()) {
+			return;
+		}
+
+		completed.swap(m_Completed);
+		m_JobCount -= completed.size();
+	}
+
+	while(!completed.empty()) {
+		JanssonJob *job = completed.front();
+		completed.pop_front();
+
+		job->RunCompletion();
+		delete job;
+	}
+}
+
+unsigned int JanssonWorkerPool::GetThreadCount() {
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_Threads.size();
+}
+
+unsigned int JanssonWorkerPool::GetJobCount() {
+	std::lock_guard<std::mutex> lock(m_Lock);
+	return m_JobCount;
+}
+
+void JanssonWorkerPool::ThreadMain() {
+	std::unique_lock<std::mutex> lock(m_Lock);
+	for(;;) {
+		while(m_bRunning && m_Pending.empty()) {
+			m_Signal.wait(lock);
+		}
+
+		if(!m_bRunning) {
+			// Values freed on this thread are cached per thread.
+			json_pool_flush();
+			return;
+		}
+
+		JanssonJob *job = m_Pending.front();
+		m_Pending.pop_front();
+
+		lock.unlock();
+		job->RunThread();
+		lock.lock();
+
+		m_Completed.push_back(job);
+	}
+}
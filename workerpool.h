@@ -0,0 +1,118 @@
+/**
+ * vim: set ts=4 :
+ * =============================================================================
+ * SMJansson
+ * Background worker support for JSON jobs.
+ * =============================================================================
+ *
+ * This program is free software; you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License, version 3.0, as published by the
+ * Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDE_SMJANSSON_WORKERPOOL_H_
+#define _INCLUDE_SMJANSSON_WORKERPOOL_H_
+
+/**
+ * @file workerpool.h
+ * @brief Runs JSON jobs off the game thread and hands the results back.
+ *
+ * All plugins share one pool with a fixed number of threads. Finished
+ * jobs are queued up and completed on the main thread once per frame.
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define JANSSON_DEFAULT_WORKER_THREADS	2
+#define JANSSON_MAX_WORKER_THREADS		16
+
+/**
+ * @brief A single unit of work.
+ *
+ * RunThread() is called on a worker thread and must not touch any
+ * SourceMod interface. RunCompletion() is called afterwards on the main
+ * thread, where it is safe to create handles and call into plugins.
+ * The job is deleted by the pool once it has been completed or dropped.
+ */
+class JanssonJob
+{
+	public:
+		virtual ~JanssonJob() {}
+
+		virtual void RunThread() = 0;
+		virtual void RunCompletion() = 0;
+};
+
+class JanssonWorkerPool
+{
+	public:
+		JanssonWorkerPool();
+
+		/**
+		 * @brief Spawns the worker threads.
+		 *
+		 * @param threads	Number of threads, clamped to the range
+		 *					1 - JANSSON_MAX_WORKER_THREADS.
+		 * @return			True on success.
+		 */
+		bool Start(unsigned int threads);
+
+		/**
+		 * @brief Stops the workers and deletes all jobs that were not
+		 * completed yet, without calling their completion.
+		 */
+		void Shutdown();
+
+		/**
+		 * @brief Queues a job. The pool takes ownership of it.
+		 *
+		 * @return			False if the pool is not running. The job is
+		 *					not deleted in that case.
+		 */
+		bool AddJob(JanssonJob *job);
+
+		/**
+		 * @brief Calls RunCompletion() on every finished job.
+		 * Must be called from the main thread.
+		 */
+		void ProcessCompleted();
+
+		/**
+		 * @brief Returns the number of running worker threads.
+		 */
+		unsigned int GetThreadCount();
+
+		/**
+		 * @brief Returns the number of jobs that were queued but not
+		 * completed on the main thread yet.
+		 */
+		unsigned int GetJobCount();
+
+	private:
+		void ThreadMain();
+
+	private:
+		std::mutex m_Lock;
+		std::condition_variable m_Signal;
+		std::deque<JanssonJob *> m_Pending;
+		std::deque<JanssonJob *> m_Completed;
+		std::vector<std::thread> m_Threads;
+		unsigned int m_JobCount;
+		bool m_bRunning;
+};
+
+extern JanssonWorkerPool g_JanssonWorkerPool;
+
+#endif // _INCLUDE_SMJANSSON_WORKERPOOL_H_